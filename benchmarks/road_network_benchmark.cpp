@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+/*
+ *  Перемещение собак за тик на картах с разным числом дорог. Карта - квадратная сетка
+ *  из side горизонтальных и side вертикальных линий, каждая нарезана на отрезки
+ *  между перекрёстками, как в картах, нарисованных по кварталам.
+ *  BM_MoveDogsRoadNetwork - то, что делает Dog::Move: коридор собаки берётся из RoadNetwork.
+ *  BM_MoveDogsLinearScan - прежний поиск дороги под собакой полным перебором всех дорог.
+ *  Время первого не должно зависеть от числа дорог, время второго растёт линейно.
+ */
+
+namespace {
+
+constexpr int BLOCK = 10;
+constexpr size_t DOG_COUNT = 1000;
+constexpr double TICK = 0.05;
+constexpr double DOG_SPEED = 3.0;
+
+std::vector<model::Road> MakeGridRoads(int side) {
+    std::vector<model::Road> roads;
+    const int extent = BLOCK * (side - 1);
+    for (int line = 0; line < side; ++line) {
+        for (int from = 0; from < extent; from += BLOCK) {
+            roads.emplace_back(model::Road::HORIZONTAL, model::Point{ from, line * BLOCK }, from + BLOCK);
+            roads.emplace_back(model::Road::VERTICAL, model::Point{ line * BLOCK, from }, from + BLOCK);
+        }
+    }
+    return roads;
+}
+
+struct DogsState {
+    std::vector<model::MapPoint> positions;
+    std::vector<model::MapSpeed> speeds;
+};
+
+// Собаки стоят в случайных местах сетки и бегут вдоль своей линии
+DogsState MakeDogs(int side) {
+    std::mt19937 rng{ 42 };
+    std::uniform_real_distribution<double> along(0.0, BLOCK * (side - 1));
+    std::uniform_int_distribution<int> line(0, side - 1);
+    DogsState dogs;
+    for (size_t i = 0; i < DOG_COUNT; ++i) {
+        const double sign = rng() % 2 == 0 ? 1.0 : -1.0;
+        if (rng() % 2 == 0) {
+            dogs.positions.push_back({ along(rng), static_cast<double>(line(rng) * BLOCK) });
+            dogs.speeds.push_back({ sign * DOG_SPEED, 0.0 });
+        }
+        else {
+            dogs.positions.push_back({ static_cast<double>(line(rng) * BLOCK), along(rng) });
+            dogs.speeds.push_back({ 0.0, sign * DOG_SPEED });
+        }
+    }
+    return dogs;
+}
+
+// Перемещение в пределах первой найденной дороги, вдоль которой идёт собака
+void MoveByScan(const std::vector<model::Road>& roads, double time, model::MapPoint& pos, model::MapSpeed& speed) {
+    const bool horizontal = speed.dx != 0;
+    for (const auto& road : roads) {
+        if (road.IsHorizontal() != horizontal) {
+            continue;
+        }
+        const double x0 = std::min(road.GetStart().x, road.GetEnd().x) - model::ROAD_RADIUS;
+        const double x1 = std::max(road.GetStart().x, road.GetEnd().x) + model::ROAD_RADIUS;
+        const double y0 = std::min(road.GetStart().y, road.GetEnd().y) - model::ROAD_RADIUS;
+        const double y1 = std::max(road.GetStart().y, road.GetEnd().y) + model::ROAD_RADIUS;
+        if (pos.x < x0 || pos.x > x1 || pos.y < y0 || pos.y > y1) {
+            continue;
+        }
+        double& coord = horizontal ? pos.x : pos.y;
+        const double next = coord + (horizontal ? speed.dx : speed.dy) * time;
+        coord = std::clamp(next, horizontal ? x0 : y0, horizontal ? x1 : y1);
+        if (coord != next) {
+            speed = { 0.0, 0.0 };
+        }
+        return;
+    }
+}
+
+void BM_MoveDogsRoadNetwork(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    const auto roads = MakeGridRoads(side);
+    model::RoadNetwork network;
+    network.Build(roads, model::ROAD_RADIUS);
+    const DogsState initial = MakeDogs(side);
+    DogsState dogs = initial;
+    std::vector<model::MapPoint> previous(DOG_COUNT);
+    std::vector<size_t> corridors(DOG_COUNT, model::RoadNetwork::NO_CORRIDOR);
+    for (auto _ : state) {
+        for (size_t i = 0; i < DOG_COUNT; ++i) {
+            model::MoveAlongRoads(network, TICK, dogs.positions[i], previous[i], dogs.speeds[i], corridors[i]);
+        }
+        benchmark::DoNotOptimize(dogs.positions.data());
+        // Каждый тик начинается с одного и того же состояния, иначе собаки постепенно соберутся у краёв дорог
+        dogs = initial;
+    }
+    state.counters["roads"] = static_cast<double>(roads.size());
+}
+
+void BM_MoveDogsLinearScan(benchmark::State& state) {
+    const int side = static_cast<int>(state.range(0));
+    const auto roads = MakeGridRoads(side);
+    const DogsState initial = MakeDogs(side);
+    DogsState dogs = initial;
+    for (auto _ : state) {
+        for (size_t i = 0; i < DOG_COUNT; ++i) {
+            MoveByScan(roads, TICK, dogs.positions[i], dogs.speeds[i]);
+        }
+        benchmark::DoNotOptimize(dogs.positions.data());
+        dogs = initial;
+    }
+    state.counters["roads"] = static_cast<double>(roads.size());
+}
+
+}  // namespace
+
+// 12, 180, 760, 1984 и 8064 дороги
+BENCHMARK(BM_MoveDogsRoadNetwork)->Arg(3)->Arg(10)->Arg(20)->Arg(32)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MoveDogsLinearScan)->Arg(3)->Arg(10)->Arg(20)->Arg(32)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
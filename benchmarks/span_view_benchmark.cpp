@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/model.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/*
+ *  Стоимость обхода состояния сессии в ответе на /api/v1/game/state: по представлениям
+ *  GetDogs, GetLoots и GetLootBag и по копиям векторов shared_ptr, которые эти методы
+ *  возвращали раньше. Счётчики allocs и refcount_ops - выделения памяти и атомарные
+ *  операции со счётчиком ссылок на один запрос.
+ */
+
+namespace {
+
+std::atomic<std::size_t> allocations{ 0 };
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+constexpr size_t BAG_SIZE = 3;
+
+model::MapSharedPtr MakeMap() {
+    auto map = std::make_shared<model::Map>(model::Map::Id{ "bench" }, "bench");
+    map->AddRoad(model::Road(model::Road::HORIZONTAL, { 0, 0 }, 100));
+    return map;
+}
+
+// Сессия с dogs собаками, у каждой в рюкзаке BAG_SIZE предметов, и loots предметами на карте
+model::GameSessionSharedPtr MakeSession(size_t dogs, size_t loots) {
+    auto session = std::make_shared<model::GameSession>(MakeMap());
+    for (size_t i = 0; i < dogs; ++i) {
+        auto dog = std::make_shared<model::Dog>("bench");
+        dog->SetBagCapacity(BAG_SIZE);
+        dog->SetPos({ static_cast<double>(i % 100), 0.0 });
+        for (size_t k = 0; k < BAG_SIZE; ++k) {
+            dog->AddLoot(std::make_shared<model::Loot>(static_cast<int>(k), 10));
+        }
+        session->AddDog(std::move(dog));
+    }
+    for (size_t i = 0; i < loots; ++i) {
+        session->AddLoot(std::make_shared<model::Loot>(0, 10, model::MapPoint{ static_cast<double>(i % 100), 0.0 }));
+    }
+    return session;
+}
+
+// Обход тех же полей, что читает сериализация состояния
+template <typename DogRange, typename BagOf, typename LootRange>
+double WalkState(const DogRange& dogs, BagOf&& bag_of, const LootRange& loots) {
+    double checksum = 0.0;
+    for (const auto& dog : dogs) {
+        checksum += dog->GetPosition().x + dog->GetSpeed().dx + dog->GetScore();
+        for (const auto& loot : bag_of(*dog)) {
+            checksum += static_cast<double>(loot->GetId() + loot->GetType());
+        }
+    }
+    for (const auto& loot : loots) {
+        checksum += loot->GetPos().x + loot->GetType();
+    }
+    return checksum;
+}
+
+void ReportCounters(benchmark::State& state, size_t allocs_before, double refcount_ops_per_request) {
+    const auto requests = static_cast<double>(state.iterations());
+    state.counters["allocs"] = static_cast<double>(allocations.load() - allocs_before) / requests;
+    state.counters["refcount_ops"] = refcount_ops_per_request;
+}
+
+void BM_StateWalkSpans(benchmark::State& state) {
+    const size_t dogs = static_cast<size_t>(state.range(0));
+    const auto session = MakeSession(dogs, dogs);
+    const size_t allocs_before = allocations.load();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(WalkState(session->GetDogs(),
+            [](const model::Dog& dog) { return dog.GetLootBag(); },
+            session->GetLoots()));
+    }
+    ReportCounters(state, allocs_before, 0.0);
+}
+
+// Прежний интерфейс: каждый метод возвращал копию вектора shared_ptr
+void BM_StateWalkCopies(benchmark::State& state) {
+    const size_t dogs = static_cast<size_t>(state.range(0));
+    const auto session = MakeSession(dogs, dogs);
+    const size_t allocs_before = allocations.load();
+    for (auto _ : state) {
+        const model::Dogs dog_copies(session->GetDogs().begin(), session->GetDogs().end());
+        const model::Loots loot_copies(session->GetLoots().begin(), session->GetLoots().end());
+        benchmark::DoNotOptimize(WalkState(dog_copies,
+            [](const model::Dog& dog) { return model::Loots(dog.GetLootBag().begin(), dog.GetLootBag().end()); },
+            loot_copies));
+    }
+    // Каждая скопированная ссылка - один инкремент и один декремент
+    ReportCounters(state, allocs_before, 2.0 * static_cast<double>(dogs + dogs * BAG_SIZE + dogs));
+}
+
+}  // namespace
+
+BENCHMARK(BM_StateWalkSpans)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_StateWalkCopies)->Arg(10)->Arg(100)->Arg(1000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/thread_pool.h"
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+/*
+ *  Пакет задач, похожий на тик игры с сессиями разного размера: стоимость задач
+ *  убывает в порядке выдачи, как у сессий, отсортированных по EstimateTickCost.
+ *  Последовательный цикл - то, что делал тик до пула.
+ */
+
+namespace {
+
+constexpr size_t TASK_COUNT = 64;
+
+// Стоимость задачи: несколько больших сессий и длинный хвост маленьких
+std::vector<std::uint64_t> MakeTaskCosts() {
+    std::vector<std::uint64_t> costs;
+    costs.reserve(TASK_COUNT);
+    for (size_t i = 0; i < TASK_COUNT; ++i) {
+        costs.push_back(200'000 / (i + 1) + 2'000);
+    }
+    return costs;
+}
+
+std::uint64_t Work(std::uint64_t iterations) {
+    std::uint64_t x = iterations;
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+    return x;
+}
+
+void BM_SequentialLoop(benchmark::State& state) {
+    const auto costs = MakeTaskCosts();
+    std::vector<std::uint64_t> results(costs.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < costs.size(); ++i) {
+            results[i] = Work(costs[i]);
+        }
+        benchmark::DoNotOptimize(results.data());
+    }
+}
+
+void BM_WorkStealingPool(benchmark::State& state) {
+    const auto costs = MakeTaskCosts();
+    std::vector<std::uint64_t> results(costs.size());
+    std::vector<size_t> items(costs.size());
+    std::iota(items.begin(), items.end(), 0);
+    WorkStealingPool pool{ static_cast<unsigned>(state.range(0)) };
+    for (auto _ : state) {
+        pool.Run(items, [&](size_t i) { results[i] = Work(costs[i]); });
+        benchmark::DoNotOptimize(results.data());
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SequentialLoop)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_WorkStealingPool)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
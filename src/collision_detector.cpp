@@ -1,5 +1,12 @@
 #include "collision_detector.h"
 #include <cassert>
+#include <cmath>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLLISION_DETECTOR_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 namespace collision_detector {
 
@@ -22,37 +29,383 @@ namespace collision_detector {
         return CollectionResult(sq_distance, proj_ratio);
     }
 
-    std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
-        std::vector<GatheringEvent> events;
-        for (size_t gatherer_idx = 0; gatherer_idx < provider.GatherersCount(); ++gatherer_idx) {
-            const Gatherer gatherer = provider.GetGatherer(gatherer_idx);
-            const auto& start_pos = gatherer.start_pos;
-            const auto& end_pos = gatherer.end_pos;
-            const double gatherer_radius = gatherer.width / 2.0;
+    namespace {
+
+        static_assert(sizeof(CollectionResult) == 2 * sizeof(double), "SIMD kernels store CollectionResult as a pair of doubles");
+
+        using CollectKernelFn = void (*)(geom::Point2D, geom::Point2D, const double*, const double*, size_t, CollectionResult*);
+
+        void TryCollectPointsScalar(geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = TryCollectPoint(a, b, { xs[i], ys[i] });
+            }
+        }
+
+#ifdef COLLISION_DETECTOR_X86_KERNELS
+        /*
+         *  Векторные ядра повторяют вычисления TryCollectPoint покомпонентно.
+         *  Хвост, не кратный ширине вектора, обрабатывается тем же ядром на дополненном блоке:
+         *  переход из AVX-кода в обычный SSE-код до vzeroupper обходится дороже, чем лишние дорожки.
+         */
+        __attribute__((target("sse2")))
+        inline void CollectBlockSse2(__m128d ax, __m128d ay, __m128d vx, __m128d vy, __m128d vl2,
+                                     const double* xs, const double* ys, double* dst) {
+            const __m128d ux = _mm_sub_pd(_mm_loadu_pd(xs), ax);
+            const __m128d uy = _mm_sub_pd(_mm_loadu_pd(ys), ay);
+            const __m128d u_dot_v = _mm_add_pd(_mm_mul_pd(ux, vx), _mm_mul_pd(uy, vy));
+            const __m128d u_len2 = _mm_add_pd(_mm_mul_pd(ux, ux), _mm_mul_pd(uy, uy));
+            const __m128d proj_ratio = _mm_div_pd(u_dot_v, vl2);
+            const __m128d sq_distance = _mm_sub_pd(u_len2, _mm_div_pd(_mm_mul_pd(u_dot_v, u_dot_v), vl2));
+            // CollectionResult - это пара {sq_distance, proj_ratio}
+            _mm_storeu_pd(dst, _mm_unpacklo_pd(sq_distance, proj_ratio));
+            _mm_storeu_pd(dst + 2, _mm_unpackhi_pd(sq_distance, proj_ratio));
+        }
+
+        __attribute__((target("sse2")))
+        void TryCollectPointsSse2(geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out) {
+            constexpr size_t WIDTH = 2;
+            const double v_x = b.x - a.x;
+            const double v_y = b.y - a.y;
+            const double v_len2 = v_x * v_x + v_y * v_y;
+            const __m128d ax = _mm_set1_pd(a.x), ay = _mm_set1_pd(a.y);
+            const __m128d vx = _mm_set1_pd(v_x), vy = _mm_set1_pd(v_y), vl2 = _mm_set1_pd(v_len2);
+            size_t i = 0;
+            for (; i + WIDTH <= count; i += WIDTH) {
+                CollectBlockSse2(ax, ay, vx, vy, vl2, xs + i, ys + i, reinterpret_cast<double*>(out + i));
+            }
+            if (i < count) {
+                double tail_xs[WIDTH] = { a.x, a.x }, tail_ys[WIDTH] = { a.y, a.y };
+                CollectionResult tail_out[WIDTH];
+                std::copy(xs + i, xs + count, tail_xs);
+                std::copy(ys + i, ys + count, tail_ys);
+                CollectBlockSse2(ax, ay, vx, vy, vl2, tail_xs, tail_ys, reinterpret_cast<double*>(tail_out));
+                std::copy(tail_out, tail_out + (count - i), out + i);
+            }
+        }
+
+        __attribute__((target("avx2")))
+        inline void CollectBlockAvx2(__m256d ax, __m256d ay, __m256d vx, __m256d vy, __m256d vl2,
+                                     const double* xs, const double* ys, double* dst) {
+            const __m256d ux = _mm256_sub_pd(_mm256_loadu_pd(xs), ax);
+            const __m256d uy = _mm256_sub_pd(_mm256_loadu_pd(ys), ay);
+            const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(ux, vx), _mm256_mul_pd(uy, vy));
+            const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(ux, ux), _mm256_mul_pd(uy, uy));
+            const __m256d proj_ratio = _mm256_div_pd(u_dot_v, vl2);
+            const __m256d sq_distance = _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), vl2));
+            // unpack даёт пары {0, 2} и {1, 3}, permute2f128 расставляет их по порядку
+            const __m256d even = _mm256_unpacklo_pd(sq_distance, proj_ratio);
+            const __m256d odd = _mm256_unpackhi_pd(sq_distance, proj_ratio);
+            _mm256_storeu_pd(dst, _mm256_permute2f128_pd(even, odd, 0x20));
+            _mm256_storeu_pd(dst + 4, _mm256_permute2f128_pd(even, odd, 0x31));
+        }
+
+        __attribute__((target("avx2")))
+        void TryCollectPointsAvx2(geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out) {
+            constexpr size_t WIDTH = 4;
+            const double v_x = b.x - a.x;
+            const double v_y = b.y - a.y;
+            const double v_len2 = v_x * v_x + v_y * v_y;
+            const __m256d ax = _mm256_set1_pd(a.x), ay = _mm256_set1_pd(a.y);
+            const __m256d vx = _mm256_set1_pd(v_x), vy = _mm256_set1_pd(v_y), vl2 = _mm256_set1_pd(v_len2);
+            size_t i = 0;
+            for (; i + WIDTH <= count; i += WIDTH) {
+                CollectBlockAvx2(ax, ay, vx, vy, vl2, xs + i, ys + i, reinterpret_cast<double*>(out + i));
+            }
+            if (i < count) {
+                double tail_xs[WIDTH] = { a.x, a.x, a.x, a.x }, tail_ys[WIDTH] = { a.y, a.y, a.y, a.y };
+                CollectionResult tail_out[WIDTH];
+                std::copy(xs + i, xs + count, tail_xs);
+                std::copy(ys + i, ys + count, tail_ys);
+                CollectBlockAvx2(ax, ay, vx, vy, vl2, tail_xs, tail_ys, reinterpret_cast<double*>(tail_out));
+                std::copy(tail_out, tail_out + (count - i), out + i);
+            }
+        }
+#endif
+
+        CollectKernelFn GetCollectKernel(CollectKernel kernel) {
+            switch (kernel) {
+            case CollectKernel::SCALAR:
+                return TryCollectPointsScalar;
+#ifdef COLLISION_DETECTOR_X86_KERNELS
+            case CollectKernel::SSE2:
+                return TryCollectPointsSse2;
+            case CollectKernel::AVX2:
+                return TryCollectPointsAvx2;
+#endif
+            default:
+                return nullptr;
+            }
+        }
+
+        CollectKernelFn SelectCollectKernel() {
+            for (const CollectKernel kernel : { CollectKernel::AVX2, CollectKernel::SSE2 }) {
+                if (IsCollectKernelSupported(kernel)) {
+                    return GetCollectKernel(kernel);
+                }
+            }
+            return TryCollectPointsScalar;
+        }
+
+        void SortEvents(std::vector<GatheringEvent>& events) {
+            // Сортируем события сначала по времени, затем по gatherer_id, затем по item_id
+            std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs) {
+                if (lhs.time != rhs.time) return lhs.time < rhs.time;
+                if (lhs.gatherer_id != rhs.gatherer_id) return lhs.gatherer_id < rhs.gatherer_id;
+                return lhs.item_id < rhs.item_id;
+                });
+        }
+
+        // Собирает данные провайдера в непрерывные массивы, чтобы дальше обойтись без виртуальных вызовов
+        std::pair<std::vector<Gatherer>, std::vector<Item>> CopyProvider(const ItemGathererProvider& provider) {
+            std::vector<Gatherer> gatherers;
+            gatherers.reserve(provider.GatherersCount());
+            for (size_t gatherer_idx = 0; gatherer_idx < provider.GatherersCount(); ++gatherer_idx) {
+                gatherers.push_back(provider.GetGatherer(gatherer_idx));
+            }
+            std::vector<Item> items;
+            items.reserve(provider.ItemsCount());
             for (size_t item_idx = 0; item_idx < provider.ItemsCount(); ++item_idx) {
-                const Item item = provider.GetItem(item_idx);
-                const auto& item_pos = item.position;
-                const double item_radius = item.width / 2.0;
-                const double collect_radius = gatherer_radius + item_radius;
-                // Проверяем возможность сбора
-                const CollectionResult result = TryCollectPoint(start_pos, end_pos, item_pos);
-                if (result.IsCollected(collect_radius)) {
-                    events.push_back({
-                        item_idx,
-                        gatherer_idx,
-                        result.sq_distance,
-                        result.proj_ratio
-                        });
+                items.push_back(provider.GetItem(item_idx));
+            }
+            return { std::move(gatherers), std::move(items) };
+        }
+
+        void TryGather(const Gatherer& gatherer, size_t gatherer_idx, const Item& item, size_t item_idx,
+                       std::vector<GatheringEvent>& events) {
+            const double collect_radius = gatherer.width / 2.0 + item.width / 2.0;
+            // Проверяем возможность сбора
+            const CollectionResult result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
+            if (result.IsCollected(collect_radius)) {
+                events.push_back({
+                    item_idx,
+                    gatherer_idx,
+                    result.sq_distance,
+                    result.proj_ratio
+                    });
+            }
+        }
+
+        // При меньшем количестве пар построение сетки дороже полного перебора
+        constexpr size_t MIN_PAIRS_FOR_GRID = 256;
+
+        // Короткие диапазоны дешевле проверить без пакетного вызова
+        constexpr size_t MIN_BATCH_SIZE = 8;
+
+    }  // namespace
+
+    ItemIndex::ItemIndex(std::span<const Item> items, double min_cell_size) {
+        if (items.empty()) {
+            return;
+        }
+        min_x_ = max_x_ = items.front().position.x;
+        min_y_ = max_y_ = items.front().position.y;
+        for (const auto& item : items) {
+            min_x_ = std::min(min_x_, item.position.x);
+            max_x_ = std::max(max_x_, item.position.x);
+            min_y_ = std::min(min_y_, item.position.y);
+            max_y_ = std::max(max_y_, item.position.y);
+            max_item_radius_ = std::max(max_item_radius_, item.width / 2.0);
+        }
+        // Ячеек не больше, чем предметов, но и не меньше размера типичного запроса
+        const double area = std::max(max_x_ - min_x_, 1.0) * std::max(max_y_ - min_y_, 1.0);
+        cell_size_ = std::max(min_cell_size, std::sqrt(area / static_cast<double>(items.size())));
+        cols_ = static_cast<size_t>((max_x_ - min_x_) / cell_size_) + 1;
+        rows_ = static_cast<size_t>((max_y_ - min_y_) / cell_size_) + 1;
+
+        std::vector<size_t> item_cells(items.size());
+        cell_begin_.assign(cols_ * rows_ + 1, 0);
+        for (size_t i = 0; i < items.size(); ++i) {
+            item_cells[i] = CellOf(items[i].position.x, items[i].position.y);
+            ++cell_begin_[item_cells[i] + 1];
+        }
+        for (size_t c = 1; c < cell_begin_.size(); ++c) {
+            cell_begin_[c] += cell_begin_[c - 1];
+        }
+        ids_.resize(items.size());
+        xs_.resize(items.size());
+        ys_.resize(items.size());
+        radii_.resize(items.size());
+        std::vector<size_t> fill(cell_begin_.begin(), cell_begin_.end() - 1);
+        for (size_t i = 0; i < items.size(); ++i) {
+            const size_t k = fill[item_cells[i]]++;
+            ids_[k] = i;
+            xs_[k] = items[i].position.x;
+            ys_[k] = items[i].position.y;
+            radii_[k] = items[i].width / 2.0;
+        }
+    }
+
+    template <typename Fn>
+    bool ItemIndex::ForEachCandidateRange(double x0, double y0, double x1, double y1, Fn&& fn) const {
+        if (x1 < min_x_ || y1 < min_y_ || x0 > max_x_ || y0 > max_y_) {
+            return true;
+        }
+        const size_t col0 = ColOf(x0), col1 = ColOf(x1);
+        const size_t row0 = RowOf(y0), row1 = RowOf(y1);
+        if ((col1 - col0 + 1) * (row1 - row0 + 1) > ids_.size()) {
+            return false;
+        }
+        for (size_t row = row0; row <= row1; ++row) {
+            // Соседние ячейки строки лежат подряд, поэтому строка - один диапазон
+            const size_t begin = cell_begin_[row * cols_ + col0];
+            const size_t end = cell_begin_[row * cols_ + col1 + 1];
+            if (begin != end) {
+                fn(begin, end);
+            }
+        }
+        return true;
+    }
+
+    void ItemIndex::Gather(const Gatherer& gatherer, size_t gatherer_idx, size_t begin, size_t end,
+                           std::vector<CollectionResult>& results, std::vector<GatheringEvent>& events) const {
+        const size_t count = end - begin;
+        if (count < MIN_BATCH_SIZE) {
+            for (size_t k = begin; k < end; ++k) {
+                AddIfCollected(gatherer, gatherer_idx, k,
+                    TryCollectPoint(gatherer.start_pos, gatherer.end_pos, { xs_[k], ys_[k] }), events);
+            }
+            return;
+        }
+        results.resize(count);
+        TryCollectPoints(gatherer.start_pos, gatherer.end_pos, xs_.data() + begin, ys_.data() + begin, count, results.data());
+        for (size_t k = begin; k < end; ++k) {
+            AddIfCollected(gatherer, gatherer_idx, k, results[k - begin], events);
+        }
+    }
+
+    void ItemIndex::AddIfCollected(const Gatherer& gatherer, size_t gatherer_idx, size_t k, const CollectionResult& result,
+                                   std::vector<GatheringEvent>& events) const {
+        if (result.IsCollected(gatherer.width / 2.0 + radii_[k])) {
+            events.push_back({
+                ids_[k],
+                gatherer_idx,
+                result.sq_distance,
+                result.proj_ratio
+                });
+        }
+    }
+
+    void ItemIndex::QueryRadius(geom::Point2D center, double radius, std::vector<size_t>& out) const {
+        if (ids_.empty()) {
+            return;
+        }
+        const double sq_radius = radius * radius;
+        const auto collect = [this, center, sq_radius, &out](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                const double dx = xs_[k] - center.x;
+                const double dy = ys_[k] - center.y;
+                if (dx * dx + dy * dy <= sq_radius) {
+                    out.push_back(ids_[k]);
                 }
             }
+        };
+        if (!ForEachCandidateRange(center.x - radius, center.y - radius, center.x + radius, center.y + radius, collect)) {
+            collect(0, ids_.size());
+        }
+    }
+
+    size_t ItemIndex::ColOf(double x) const {
+        return static_cast<size_t>(std::clamp((x - min_x_) / cell_size_, 0.0, static_cast<double>(cols_ - 1)));
+    }
+
+    size_t ItemIndex::RowOf(double y) const {
+        return static_cast<size_t>(std::clamp((y - min_y_) / cell_size_, 0.0, static_cast<double>(rows_ - 1)));
+    }
+
+    size_t ItemIndex::CellOf(double x, double y) const {
+        return RowOf(y) * cols_ + ColOf(x);
+    }
+
+    void TryCollectPoints(geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out) {
+        static const CollectKernelFn kernel = SelectCollectKernel();
+        kernel(a, b, xs, ys, count, out);
+    }
+
+    bool IsCollectKernelSupported(CollectKernel kernel) {
+        switch (kernel) {
+        case CollectKernel::SCALAR:
+            return true;
+#ifdef COLLISION_DETECTOR_X86_KERNELS
+        case CollectKernel::SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case CollectKernel::AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    void TryCollectPoints(CollectKernel kernel, geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out) {
+        assert(IsCollectKernelSupported(kernel));
+        GetCollectKernel(kernel)(a, b, xs, ys, count, out);
+    }
+
+    std::vector<GatheringEvent> FindGatherEvents(std::span<const Gatherer> gatherers, const ItemIndex& items) {
+        std::vector<GatheringEvent> events;
+        if (items.Empty()) {
+            return events;
+        }
+        std::vector<CollectionResult> results;
+        for (size_t gatherer_idx = 0; gatherer_idx < gatherers.size(); ++gatherer_idx) {
+            const Gatherer& gatherer = gatherers[gatherer_idx];
+            const double reach = gatherer.width / 2.0 + items.max_item_radius_;
+            const bool done = items.ForEachCandidateRange(
+                std::min(gatherer.start_pos.x, gatherer.end_pos.x) - reach,
+                std::min(gatherer.start_pos.y, gatherer.end_pos.y) - reach,
+                std::max(gatherer.start_pos.x, gatherer.end_pos.x) + reach,
+                std::max(gatherer.start_pos.y, gatherer.end_pos.y) + reach,
+                [&](size_t begin, size_t end) {
+                    items.Gather(gatherer, gatherer_idx, begin, end, results, events);
+                });
+            if (!done) {
+                items.Gather(gatherer, gatherer_idx, 0, items.Size(), results, events);
+            }
         }
-        // Сортируем события сначала по времени, затем по gatherer_id, затем по item_id
-        std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs) {
-            if (lhs.time != rhs.time) return lhs.time < rhs.time;
-            if (lhs.gatherer_id != rhs.gatherer_id) return lhs.gatherer_id < rhs.gatherer_id;
-            return lhs.item_id < rhs.item_id;
-            });
+        SortEvents(events);
         return events;
     }
 
-}  // namespace collision_detector
\ No newline at end of file
+    std::vector<GatheringEvent> FindGatherEvents(std::span<const Gatherer> gatherers, std::span<const Item> items) {
+        if (items.size() * gatherers.size() < MIN_PAIRS_FOR_GRID) {
+            return FindGatherEventsBruteForce(gatherers, items);
+        }
+
+        double max_item_radius = 0.0;
+        for (const Item& item : items) {
+            max_item_radius = std::max(max_item_radius, item.width / 2.0);
+        }
+        double total_extent = 0.0;
+        for (const Gatherer& g : gatherers) {
+            total_extent += std::abs(g.end_pos.x - g.start_pos.x) + std::abs(g.end_pos.y - g.start_pos.y) + g.width;
+        }
+
+        // Размер ячейки - порядка размера прямоугольника, заметаемого средним собирателем
+        const ItemIndex index(items, total_extent / static_cast<double>(gatherers.size()) + 2.0 * max_item_radius);
+        return FindGatherEvents(gatherers, index);
+    }
+
+    std::vector<GatheringEvent> FindGatherEventsBruteForce(std::span<const Gatherer> gatherers, std::span<const Item> items) {
+        std::vector<GatheringEvent> events;
+        for (size_t gatherer_idx = 0; gatherer_idx < gatherers.size(); ++gatherer_idx) {
+            for (size_t item_idx = 0; item_idx < items.size(); ++item_idx) {
+                TryGather(gatherers[gatherer_idx], gatherer_idx, items[item_idx], item_idx, events);
+            }
+        }
+        SortEvents(events);
+        return events;
+    }
+
+    std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+        const auto [gatherers, items] = CopyProvider(provider);
+        return FindGatherEvents(gatherers, items);
+    }
+
+    std::vector<GatheringEvent> FindGatherEventsBruteForce(const ItemGathererProvider& provider) {
+        const auto [gatherers, items] = CopyProvider(provider);
+        return FindGatherEventsBruteForce(gatherers, items);
+    }
+
+}  // namespace collision_detector
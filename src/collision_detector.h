@@ -3,6 +3,7 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <span>
 #include <vector>
 #include <cassert>
 
@@ -33,6 +34,27 @@ struct CollectionResult {
 // Функция корректно работает только при условии ненулевого перемещения.
 CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D c);
 
+// Пакетный вариант TryCollectPoint: движемся из a в b и пытаемся подобрать точки (xs[i], ys[i]), i < count.
+// Результат для i-й точки записывается в out[i]. Реализация (AVX2, SSE2 или скалярная) выбирается
+// при первом вызове по возможностям процессора. Все реализации выполняют те же операции в том же порядке,
+// что и TryCollectPoint, поэтому результаты совпадают побитово, в том числе для нулевого перемещения.
+// Для этого collision_detector.cpp собирается с -ffp-contract=off: иначе компилятор мог бы слить
+// умножение и сложение скалярного кода в FMA, а векторного - нет
+void TryCollectPoints(geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out);
+
+// Реализации TryCollectPoints. Явный выбор нужен, чтобы сравнивать реализации между собой
+enum class CollectKernel {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Поддерживают ли реализацию сборка и процессор
+bool IsCollectKernelSupported(CollectKernel kernel);
+
+// TryCollectPoints с заданной реализацией. Реализация должна поддерживаться
+void TryCollectPoints(CollectKernel kernel, geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count, CollectionResult* out);
+
 struct Item {
     geom::Point2D position;
     double width;
@@ -62,6 +84,72 @@ struct GatheringEvent {
     double time;
 };
 
+// Находит все события сбора, упорядоченные по времени, затем по gatherer_id, затем по item_id.
+// Пары "собиратель - предмет", которые заведомо не могут пересечься, отсекаются по равномерной сетке.
+// gatherer_id и item_id событий - индексы в массивах gatherers и items
+std::vector<GatheringEvent> FindGatherEvents(std::span<const Gatherer> gatherers, std::span<const Item> items);
+
+// Эталонная реализация полным перебором всех пар. Результат совпадает с FindGatherEvents
+std::vector<GatheringEvent> FindGatherEventsBruteForce(std::span<const Gatherer> gatherers, std::span<const Item> items);
+
+/*
+ *  Равномерная сетка предметов для отсечения пар, которые заведомо не могут пересечься.
+ *  Каждый предмет лежит ровно в одной ячейке, поэтому одна пара не может быть проверена дважды.
+ *  Ячейки хранятся в сжатом виде: предметы отсортированы по номеру ячейки,
+ *  cell_begin_[c] - начало предметов ячейки c. Координаты и радиусы предметов
+ *  лежат в том же порядке в отдельных массивах, чтобы ячейку можно было
+ *  проверить одним вызовом TryCollectPoints.
+ *  Для неподвижных предметов (офисов) индекс строится один раз и затем только читается.
+ */
+class ItemIndex {
+public:
+    ItemIndex() = default;
+
+    // min_cell_size - нижняя граница размера ячейки, разумно брать порядка размера пути собирателя
+    ItemIndex(std::span<const Item> items, double min_cell_size);
+
+    size_t Size() const noexcept { return ids_.size(); }
+
+    bool Empty() const noexcept { return ids_.empty(); }
+
+    // Добавляет в out номера предметов, центры которых лежат не дальше radius от center
+    void QueryRadius(geom::Point2D center, double radius, std::vector<size_t>& out) const;
+
+private:
+    friend std::vector<GatheringEvent> FindGatherEvents(std::span<const Gatherer> gatherers, const ItemIndex& items);
+
+    // Вызывает fn(begin, end) для непрерывных диапазонов предметов из ячеек, пересекающих прямоугольник.
+    // Возвращает false, если прямоугольник покрывает слишком много ячеек и выгоднее полный перебор
+    template <typename Fn>
+    bool ForEachCandidateRange(double x0, double y0, double x1, double y1, Fn&& fn) const;
+
+    // Проверяет предметы диапазона [begin, end) на пути собирателя
+    void Gather(const Gatherer& gatherer, size_t gatherer_idx, size_t begin, size_t end,
+                std::vector<CollectionResult>& results, std::vector<GatheringEvent>& events) const;
+
+    void AddIfCollected(const Gatherer& gatherer, size_t gatherer_idx, size_t k, const CollectionResult& result,
+                        std::vector<GatheringEvent>& events) const;
+
+    size_t ColOf(double x) const;
+    size_t RowOf(double y) const;
+    size_t CellOf(double x, double y) const;
+
+    double min_x_ = 0.0, min_y_ = 0.0, max_x_ = 0.0, max_y_ = 0.0;
+    double cell_size_ = 1.0;
+    double max_item_radius_ = 0.0;
+    size_t cols_ = 0, rows_ = 0;
+    std::vector<size_t> cell_begin_;
+    std::vector<size_t> ids_;
+    std::vector<double> xs_, ys_, radii_;
+};
+
+// Вариант для заранее построенного индекса предметов. item_id событий - номера предметов
+// в массиве, по которому построен индекс. Результат совпадает с FindGatherEvents(gatherers, items)
+std::vector<GatheringEvent> FindGatherEvents(std::span<const Gatherer> gatherers, const ItemIndex& items);
+
+// Варианты для провайдера: данные один раз копируются в массивы, после чего вызывается вариант для массивов
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
 
+std::vector<GatheringEvent> FindGatherEventsBruteForce(const ItemGathererProvider& provider);
+
 }  // namespace collision_detector
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace util {
+
+/*
+ *  Быстрый генератор псевдослучайных чисел xoshiro256**.
+ *  Удовлетворяет требованиям UniformRandomBitGenerator, поэтому подходит для std::uniform_*_distribution.
+ *  В отличие от std::random_device не обращается к системному источнику энтропии,
+ *  а в отличие от std::mt19937 занимает 32 байта и инициализируется одним 64-битным числом.
+ */
+class FastRandom {
+public:
+    using result_type = std::uint64_t;
+
+    explicit FastRandom(std::uint64_t seed = 0) noexcept { Seed(seed); }
+
+    // Состояние заполняется через SplitMix64, поэтому годится любое зерно, в том числе 0
+    void Seed(std::uint64_t seed) noexcept {
+        for (auto& word : state_) {
+            word = SplitMix64(seed);
+        }
+    }
+
+    static constexpr result_type min() noexcept { return 0; }
+    static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() noexcept {
+        const std::uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+        const std::uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotl(state_[3], 45);
+        return result;
+    }
+
+    // Равномерно распределённое число из [0, 1)
+    double NextDouble() noexcept {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+    // Перемешивает зерно и номер потока в зерно для отдельного генератора,
+    // чтобы генераторы с соседними номерами не были коррелированы
+    static std::uint64_t DeriveSeed(std::uint64_t seed, std::uint64_t stream) noexcept {
+        std::uint64_t x = seed ^ (stream * 0x9E3779B97F4A7C15ull);
+        return SplitMix64(x);
+    }
+
+private:
+    static std::uint64_t Rotl(std::uint64_t x, int k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static std::uint64_t SplitMix64(std::uint64_t& x) noexcept {
+        std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    std::uint64_t state_[4];
+};
+
+}  // namespace util
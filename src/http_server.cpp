@@ -28,6 +28,11 @@ namespace http_server
             return ReportError(ec_, "read"sv);
         }
 
+        // После перехода на WebSocket соединение обслуживает обработчик перехода, а HTTP-сессия завершается
+        if (upgrade_handler && websocket::is_upgrade(request)) {
+            return upgrade_handler(std::move(request), std::move(stream));
+        }
+
         HandleRequest(std::move(request));
     }
 
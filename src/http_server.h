@@ -7,7 +7,9 @@
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
 
+#include <functional>
 #include <iostream>
 
 namespace http_server
@@ -16,9 +18,13 @@ namespace http_server
     using tcp = net::ip::tcp;
     namespace beast = boost::beast;
     namespace http = beast::http;
+    namespace websocket = beast::websocket;
 
     void ReportError(beast::error_code ec_, std::string_view what_);
 
+    //     WebSocket    ,  HTTP-   
+    using UpgradeHandler = std::function<void(http::request<http::string_body>&&, beast::tcp_stream&&)>;
+
     class SessionBase {
     public:
         void Run();
@@ -28,7 +34,8 @@ namespace http_server
     protected:
         using HttpRequest = http::request<http::string_body>;
 
-        explicit SessionBase(tcp::socket&& socket_) : stream(std::move(socket_)) {}
+        explicit SessionBase(tcp::socket&& socket_, UpgradeHandler upgrade_handler_ = {})
+            : stream(std::move(socket_)), upgrade_handler(std::move(upgrade_handler_)) {}
 
         template <typename Body, typename Fields>
         void Write(http::response<Body, Fields>&& response_) {
@@ -59,14 +66,15 @@ namespace http_server
         beast::flat_buffer buffer;
         HttpRequest request;
         beast::tcp_stream stream;
+        UpgradeHandler upgrade_handler;
     };
 
     template <typename RequestHandler>
     class Session : public SessionBase, public std::enable_shared_from_this<Session<RequestHandler>> {
     public:
         template <typename Handler>
-        Session(tcp::socket&& socket_, Handler&& request_handler_)
-            : SessionBase(std::move(socket_)), request_handler(std::forward<Handler>(request_handler_)) {}
+        Session(tcp::socket&& socket_, Handler&& request_handler_, UpgradeHandler upgrade_handler_ = {})
+            : SessionBase(std::move(socket_), std::move(upgrade_handler_)), request_handler(std::forward<Handler>(request_handler_)) {}
 
     private:
         void HandleRequest(HttpRequest&& request_) override {
@@ -86,8 +94,8 @@ namespace http_server
     template <typename RequestHandler>
     class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
     public:
-        Listener(net::io_context& ioc_, tcp::endpoint endpoint_, RequestHandler handler_)
-            : ioc(ioc_), acceptor(net::make_strand(ioc_)), request_handler(std::move(handler_)) {
+        Listener(net::io_context& ioc_, tcp::endpoint endpoint_, RequestHandler handler_, UpgradeHandler upgrade_handler_ = {})
+            : ioc(ioc_), acceptor(net::make_strand(ioc_)), request_handler(std::move(handler_)), upgrade_handler(std::move(upgrade_handler_)) {
             acceptor.open(endpoint_.protocol());
             acceptor.set_option(net::socket_base::reuse_address(true));
             acceptor.bind(endpoint_);
@@ -110,7 +118,7 @@ namespace http_server
                 ReportError(ec_, "accept"sv);
             }
             else {
-                std::make_shared<Session<RequestHandler>>(std::move(socket_), request_handler)->Run();
+                std::make_shared<Session<RequestHandler>>(std::move(socket_), request_handler, upgrade_handler)->Run();
             }
             DoAccept();
         }
@@ -118,12 +126,13 @@ namespace http_server
         net::io_context& ioc;
         tcp::acceptor acceptor;
         RequestHandler request_handler;
+        UpgradeHandler upgrade_handler;
     };
 
     template <typename RequestHandler>
-    void ServeHttp(net::io_context& ioc_, const tcp::endpoint& endpoint_, RequestHandler&& handler_) {
+    void ServeHttp(net::io_context& ioc_, const tcp::endpoint& endpoint_, RequestHandler&& handler_, UpgradeHandler upgrade_handler_ = {}) {
         using MyListener = Listener<std::decay_t<RequestHandler>>;
-        std::make_shared<MyListener>(ioc_, endpoint_, std::forward<RequestHandler>(handler_))->Run();
+        std::make_shared<MyListener>(ioc_, endpoint_, std::forward<RequestHandler>(handler_), std::move(upgrade_handler_))->Run();
     }
 
 }  // namespace http_server
\ No newline at end of file
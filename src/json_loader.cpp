@@ -43,6 +43,31 @@ namespace json_loader
             default_afk_time = json_value.as_object().at("dogRetirementTime").as_double();
         }
         game.SetDefaultAFKtime(default_afk_time);
+
+        size_t default_session_capacity = 0;
+        if (json_value.is_object() && json_value.as_object().contains("defaultSessionCapacity")) {
+            default_session_capacity = json_value.as_object().at("defaultSessionCapacity").to_number<std::uint64_t>();
+        }
+        game.SetDefaultSessionCapacity(default_session_capacity);
+
+        model::SessionPlacement session_placement = model::SessionPlacement::FILL_FIRST;
+        if (json_value.is_object() && json_value.as_object().contains("sessionPlacement")) {
+            const auto& placement = json_value.as_object().at("sessionPlacement").as_string();
+            if (placement == "leastLoaded") {
+                session_placement = model::SessionPlacement::LEAST_LOADED;
+            }
+            else if (placement != "fillFirst") {
+                throw std::runtime_error("Unknown session placement: " + std::string(placement));
+            }
+        }
+        game.SetSessionPlacement(session_placement);
+
+        // Радиус области видимости игрока. 0 - игрок видит всю сессию
+        double area_of_interest_radius = 0.0;
+        if (json_value.is_object() && json_value.as_object().contains("areaOfInterestRadius")) {
+            area_of_interest_radius = json_value.as_object().at("areaOfInterestRadius").to_number<double>();
+        }
+        game.SetAreaOfInterestRadius(area_of_interest_radius);
     }
 
     void ConfigureLootGenerator(model::Game& game, const boost::json::value& json_value) {
@@ -103,6 +128,13 @@ namespace json_loader
         else {
             map.SetDefaultBagCapacity(game.GetDefaultLootBagCapacity());
         }
+
+        if (map_obj.contains("sessionCapacity")) {
+            map.SetSessionCapacity(map_obj.at("sessionCapacity").to_number<std::uint64_t>());
+        }
+        else {
+            map.SetSessionCapacity(game.GetDefaultSessionCapacity());
+        }
     }
 
     void LoadRoads(model::Map& map, const boost::json::object& map_obj) {
@@ -127,6 +159,7 @@ namespace json_loader
                 ));
             }
         }
+        map.BuildRoadNetwork();
     }
 
     void LoadBuildings(model::Map& map, const boost::json::object& map_obj) {
@@ -161,6 +194,7 @@ namespace json_loader
                 offset
             ));
         }
+        map.BuildOfficeIndex();
     }
 
     rawinfo::FrontendInfo LoadRawInfo(const std::filesystem::path& json_path) {
@@ -15,7 +15,8 @@ public:
     /*
      * base_interval - базовый отрезок времени > 0
      * probability - вероятность появления трофея в течение базового интервала времени
-     * random_generator - генератор псевдослучайных чисел в диапазоне от [0 до 1]
+     * random_generator - генератор псевдослучайных чисел в диапазоне от [0 до 1].
+     * По умолчанию всегда 1.0: лут появляется с максимальной вероятностью
      */
     LootGenerator(TimeInterval base_interval, double probability,
                   RandomGenerator random_gen = DefaultGenerator)
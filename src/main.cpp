@@ -35,7 +35,12 @@ struct Args {
     std::string config_file;
     std::string static_folder;
     bool dog_random_spawner = false;
+    bool event_driven_movement = false;
     std::string mileseconds_str;
+    std::string simulation_threads_str;
+    std::string random_seed_str;
+    std::string fixed_step_str;
+    std::string max_catch_up_steps_str;
     std::string savetime_period_mileseconds_str;
     std::string game_state_file_path;
 };
@@ -51,6 +56,16 @@ struct Args {
         ("help,h", "produce help message")
         // Параметр --tick-period (-t) задаёт период автоматического обновления игрового состояния в миллисекундах. Если этот параметр указан, каждые N миллисекунд сервер должен обновлять координаты объектов. Если этот параметр не указан, время в игре должно управляться с помощью запроса /api/v1/game/tick к REST API.
         ("tick-period,t", po::value(&args.mileseconds_str)->value_name("milliseconds"s), "set tick period")
+        // Параметр --sim-threads задаёт количество потоков, на которых параллельно обновляются игровые сессии. По умолчанию сессии обновляются последовательно.
+        ("sim-threads", po::value(&args.simulation_threads_str)->value_name("threads"s), "set number of simulation threads")
+        // Параметр --fixed-step включает моделирование фиксированными шагами заданной длины в миллисекундах. Время тиков накапливается и расходуется целыми шагами.
+        ("fixed-step", po::value(&args.fixed_step_str)->value_name("milliseconds"s), "set fixed simulation step")
+        // Параметр --max-catch-up-steps ограничивает число фиксированных шагов за один тик. Время сверх этого отбрасывается. По умолчанию ограничения нет.
+        ("max-catch-up-steps", po::value(&args.max_catch_up_steps_str)->value_name("steps"s), "set max simulation steps per tick")
+        // Параметр --event-driven включает событийное перемещение собак: за тик каждая собака сразу проходит путь до остановки, а подбор и сдача лута обрабатываются в порядке наступления.
+        ("event-driven", "advance dogs from event to event")
+        // Параметр --random-seed задаёт зерно генераторов случайных чисел игры, делая появление лута и собак воспроизводимым. По умолчанию зерно выбирается случайно при запуске.
+        ("random-seed", po::value(&args.random_seed_str)->value_name("seed"s), "set random seed")
         // Параметр --config-file (-c) задаёт путь к конфигурационному JSON-файлу игры.
         ("config-file,c", po::value(&args.config_file)->value_name("file"s), "set config file path")
         // Параметр --www-root (-w) задаёт путь к каталогу со статическими файлами игры.
@@ -85,6 +100,9 @@ struct Args {
         args.dog_random_spawner = true;
         LogParamInfo("randomize-spawn-points", "Diabled: Dogs will spawn at the beginning of map");
     }
+    if (vm.contains("event-driven")) {
+        args.event_driven_movement = true;
+    }
     if (!vm.contains("state-file")) {
         LogParamInfo("stat-file", "Was not set: Game will run without saves");
         if (vm.contains("save-state-period")) {
@@ -108,6 +126,10 @@ int main(int argc, const char* argv[]) {
 
         // 1. Загружаем карту из файла и строим модель игры
         model::Game game = json_loader::LoadGame(args.config_file);
+        // зерно случайных чисел задаётся до загрузки сессий
+        if (!args.random_seed_str.empty()) {
+            game.SetRandomSeed(std::stoull(args.random_seed_str));
+        }
         // загрузка состояния игры
         if ((args.game_state_file_path.size() != 0) && (FS::exists(FS::path(args.game_state_file_path)) == true)) {
             try {
@@ -120,6 +142,19 @@ int main(int argc, const char* argv[]) {
                 return EXIT_FAILURE;
             }
         }
+        // параллельное обновление сессий
+        if (!args.simulation_threads_str.empty()) {
+            game.SetSimulationThreads(static_cast<unsigned>(std::stoi(args.simulation_threads_str)));
+        }
+        // моделирование фиксированным шагом
+        if (!args.fixed_step_str.empty()) {
+            const unsigned max_catch_up_steps = args.max_catch_up_steps_str.empty() ? 0u : static_cast<unsigned>(std::stoi(args.max_catch_up_steps_str));
+            game.SetFixedStep(std::chrono::milliseconds(std::stoi(args.fixed_step_str)), max_catch_up_steps);
+        }
+        // событийное перемещение собак
+        if (args.event_driven_movement) {
+            game.SetEventDrivenMovement(true);
+        }
         // проверка рандомного спавна
         if (args.dog_random_spawner) {
             game.EnableRandomSpawner();
@@ -152,6 +187,13 @@ int main(int argc, const char* argv[]) {
         }
 
         net::io_context ioc(num_threads);
+        // Каждая игровая сессия получает свой strand для обработки запросов
+        game.BindIoContext(ioc);
+
+        // 2.4 Создаём обработчик HTTP-запросов и связываем его с моделью игры и корневым каталогом статических файлов.
+        // Обработчик нужен тикеру раньше запуска сервера: после каждого тика он рассылает состояние по WebSocket
+        http_handler::RequestHandler handler{ game, frontend_info, static_files_root, ioc };
+        http_handler::LoggingRequestHandler logging_hangler{ handler };
 
         // 2.5 Инициализируем Ticker
         auto ticker_strand = net::make_strand(ioc);
@@ -161,11 +203,16 @@ int main(int argc, const char* argv[]) {
         if (!args.mileseconds_str.empty()) {
             int ms = std::stoi(args.mileseconds_str);
             std::chrono::milliseconds update_period(ms);
+            game.GetTickProfiler().SetTickBudget(update_period);
             ticker_game_update = std::make_shared<Ticker>(
                 ticker_strand,
                 std::chrono::milliseconds(update_period),
-                [&game](std::chrono::milliseconds ms) {
-                    game.Update(ms);
+                [&game, &handler](std::chrono::milliseconds ms) {
+                    {
+                        std::unique_lock lock{ game.GetStateMutex() };
+                        game.Update(ms);
+                    }
+                    handler.PublishState();
                 });
             ticker_game_update->Start();
         }
@@ -191,6 +238,7 @@ int main(int argc, const char* argv[]) {
                     save_period,
                     [&game](std::chrono::milliseconds) {
                         try {
+                            std::unique_lock lock{ game.GetStateMutex() };
                             game.SaveGameState();
                             LogEventInfo("Game saved", "Game state saved automatically.");
                         }
@@ -210,6 +258,7 @@ int main(int argc, const char* argv[]) {
             ](const boost::system::error_code& ec, int signal) {
                     if (!ec) {
                         try {
+                            std::unique_lock lock{ game.GetStateMutex() };
                             game.SaveGameState();
                             LogEventInfo("Game saved", "Game state saved before shutdown.");
                         }
@@ -233,10 +282,6 @@ int main(int argc, const char* argv[]) {
                 });
         }
 
-        // 4. Создаём обработчик HTTP-запросов и связываем его с моделью игры и корневым каталогом статических файлов
-        http_handler::RequestHandler handler{ game, frontend_info, static_files_root, ioc };
-        http_handler::LoggingRequestHandler logging_hangler{ handler };
-
         // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
         const auto address = net::ip::make_address("0.0.0.0");
         constexpr net::ip::port_type port = 8080;
@@ -246,6 +291,8 @@ int main(int argc, const char* argv[]) {
                 logging_hangler(std::forward<decltype(req)>(req)
                     , std::forward<decltype(send)>(send)
                     , socket);
+            }, [&handler](boost::beast::http::request<boost::beast::http::string_body>&& req, boost::beast::tcp_stream&& stream) {
+                handler.HandleUpgrade(std::move(req), std::move(stream));
             });
 
         // Эта надпись сообщает тестам о том, что сервер запущен и готов обрабатывать запросы
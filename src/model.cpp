@@ -25,6 +25,52 @@ namespace model {
             offices_.pop_back();
             throw;
         }
+        office_items_.push_back({ { static_cast<double>(o.GetPosition().x), static_cast<double>(o.GetPosition().y) }, BASE_RADIUS });
+    }
+
+    void Map::BuildRoadNetwork() {
+        road_network_.Build(roads_, ROAD_RADIUS);
+
+        road_length_prefix_.clear();
+        road_length_prefix_.reserve(roads_.size());
+        double total_length = 0.0;
+        for (const auto& road : roads_) {
+            total_length += std::abs(road.GetEnd().x - road.GetStart().x) + std::abs(road.GetEnd().y - road.GetStart().y);
+            road_length_prefix_.push_back(total_length);
+        }
+    }
+
+    MapPoint Map::GetRandomPointOnRoads(util::FastRandom& random) const {
+        if (roads_.empty()) {
+            throw std::logic_error("Map "s + *id_ + " has no roads"s);
+        }
+        const double total_length = road_length_prefix_.back();
+        if (total_length == 0.0) {
+            // Все дороги нулевой длины - выбираем любую из них
+            const Point start = roads_[random() % roads_.size()].GetStart();
+            return MapPoint(start.x, start.y);
+        }
+
+        // Дороги нулевой длины не занимают места на отрезке [0, total_length) и никогда не выбираются
+        const double offset = random.NextDouble() * total_length;
+        const size_t road_idx = std::min<size_t>(
+            std::upper_bound(road_length_prefix_.begin(), road_length_prefix_.end(), offset) - road_length_prefix_.begin(),
+            roads_.size() - 1);
+        const double along = offset - (road_idx > 0 ? road_length_prefix_[road_idx - 1] : 0.0);
+
+        const Point start = roads_[road_idx].GetStart();
+        const Point end = roads_[road_idx].GetEnd();
+        if (roads_[road_idx].IsHorizontal()) {
+            const double x = end.x >= start.x ? start.x + along : start.x - along;
+            return MapPoint(x, start.y);
+        }
+        const double y = end.y >= start.y ? start.y + along : start.y - along;
+        return MapPoint(start.x, y);
+    }
+
+    void Map::BuildOfficeIndex() {
+        // Ячейка не меньше пути собаки за типичный ход вместе с шириной собаки и радиусом офиса
+        office_index_ = collision_detector::ItemIndex(office_items_, 2.0 * (BASE_RADIUS + ROAD_RADIUS));
     }
 
     void Game::AddMap(Map map) {
@@ -33,8 +79,26 @@ namespace model {
             throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
         }
         else {
-            maps_.emplace_back(std::make_shared<Map> (map));
+            maps_.emplace_back(std::make_shared<const Map>(std::move(map)));
+        }
+    }
+
+    void Game::RemovePlayerAndSaveStats(DogSharedPtr dog, GameSessionSharedPtr session) {
+        std::lock_guard players_lock{ *players_mutex_ };
+        auto player_it = std::find_if(players_.begin(), players_.end(), [&dog](const auto& token_and_player) {
+            return token_and_player.second.GetDog() == dog;
+            });
+
+        if (pool_) {
+            const std::string name = player_it != players_.end() ? player_it->second.GetName() : dog->GetName();
+            postgres::Database::SaveRecord(pool_, PlayerRecord{ name, dog->GetScore(), dog->GetPlaytime() });
+        }
+
+        if (player_it != players_.end()) {
+            players_.erase(player_it);
         }
+        dog_id_to_session_id_.erase(dog->GetId());
+        session->RemoveDog(dog->GetId());
     }
 
     void Game::SaveGameState() {
@@ -75,6 +139,7 @@ namespace model {
             }
 
             // Сохраняем игроков
+            std::shared_lock players_lock{ *players_mutex_ };
             size_t players_count = players_.size();
             output_archive << players_count;
             for (const auto& p : players_) {
@@ -122,9 +187,7 @@ namespace model {
             for (size_t i = 0; i < sessions_count; i++) {
                 serialization::GameSessionRepr sess_repr;
                 input_archive >> sess_repr;
-                const auto& sess = sess_repr.Restore(*this);
-                game_sessions_.push_back(sess);
-                sessions_[sess->GetMap()->GetId()] = sess;
+                RegisterSession(sess_repr.Restore(*this));
             }
 
 
@@ -134,10 +197,11 @@ namespace model {
                 serialization::PlayerRepr player_repr;
                 input_archive >> player_repr;
 
-                if (auto current_dogs_session = dog_id_to_session_id_.find(player_repr.GetDogId()); current_dogs_session != dog_id_to_session_id_.end()) {
-                    Player player = player_repr.Restore(game_sessions_.at(current_dogs_session->second)->GetDog(player_repr.GetDogId()));
+                if (auto current_dogs_session = FindDogSession(player_repr.GetDogId())) {
+                    Player player = player_repr.Restore(current_dogs_session->GetDog(player_repr.GetDogId()));
+                    std::lock_guard players_lock{ *players_mutex_ };
                     players_.emplace( player.GetAuthToken(), player);
-                    game_sessions_.at(current_dogs_session->second)->UpdateSessionPlayersIdCounter();
+                    UpdatePlayerIdCounter(player);
                 }
                 else {
                     LogEventInfo("Unable to restore a player", "Dog session not found.");
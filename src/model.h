@@ -1,21 +1,39 @@
 #pragma once
 
 #include <boost/geometry.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <atomic>
 #include <memory>
 #include <random>
 #include <unordered_map>
 #include <utility>
 #include <filesystem>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <chrono>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <map>
+#include <numeric>
+#include <limits>
+#include <tuple>
+#include <queue>
+#include <deque>
+#include <functional>
+#include <algorithm>
+#include <cmath>
 
 #include "tagged.h"
 #include "loot_generator.h"
 #include "collision_detector.h"
+#include "road_network.h"
+#include "thread_pool.h"
+#include "slot_map.h"
+#include "fast_random.h"
+#include "tick_profiler.h"
 #include "postgres.h"
 
 namespace FS = std::filesystem;
@@ -31,7 +49,8 @@ namespace model {
     using LootSharedPtr = std::shared_ptr<Loot>;
     using Loots = std::vector<LootSharedPtr>;
     class Map;
-    using MapSharedPtr = std::shared_ptr<Map>;
+    // Карта после загрузки неизменна и разделяется между всеми сессиями на ней
+    using MapSharedPtr = std::shared_ptr<const Map>;
 
     constexpr double ROAD_RADIUS = 0.4;
     constexpr double LOOT_RADIUS = 0.0;
@@ -200,6 +219,14 @@ public:
 
     const Offices& GetOffices() const noexcept { return offices_; }
 
+    // Офисы в виде предметов для FindGatherEvents, в том же порядке, что и GetOffices
+    const std::vector<collision_detector::Item>& GetOfficeItems() const noexcept { return office_items_; }
+
+    // Пространственный индекс офисов. Офисы неподвижны, поэтому индекс строится один раз при загрузке карты
+    void BuildOfficeIndex();
+
+    const collision_detector::ItemIndex& GetOfficeIndex() const noexcept { return office_index_; }
+
     const double GetDefaultDogSpeed() const noexcept { return map_default_dogs_speed; }
 
     const uint64_t GetDefaultBagCapacity() const noexcept { return map_default_bag_capacity; }
@@ -210,6 +237,15 @@ public:
 
     void AddRoad(const Road& road) { roads_.emplace_back(road); }
 
+    // Компилирует дорожную сеть карты и таблицу длин дорог для GetRandomPointOnRoads.
+    // Вызывается один раз после загрузки всех дорог карты
+    void BuildRoadNetwork();
+
+    // Случайная точка, равномерно распределённая по суммарной длине дорог карты. O(log n) от числа дорог
+    MapPoint GetRandomPointOnRoads(util::FastRandom& random) const;
+
+    const RoadNetwork& GetRoadNetwork() const noexcept { return road_network_; }
+
     void AddBuilding(const Building& building) { buildings_.emplace_back(building); }
 
     void SetDefaultDogsSpeed(double speed) { map_default_dogs_speed = speed; }
@@ -222,17 +258,11 @@ public:
 
     void SetDefaultBagCapacity(uint64_t capacity) { map_default_bag_capacity = capacity; }
 
-    size_t GetPlayerIdCounter() const {
-        return player_id_counter_;
-    }
-    void SetPlayerIdCounter(size_t counter) {
-        player_id_counter_ = counter;
-    }
-    size_t UpdatePlayerIdCounter() {
-        size_t res = player_id_counter_;
-        ++player_id_counter_;
-        return res;
-    }
+    // Наибольшее количество собак в одном экземпляре сессии на карте. 0 - без ограничения
+    void SetSessionCapacity(size_t capacity) { session_capacity_ = capacity; }
+
+    size_t GetSessionCapacity() const noexcept { return session_capacity_; }
+
 
 
 private:
@@ -241,14 +271,19 @@ private:
     Id id_;
     std::string name_;
     Roads roads_;
+    RoadNetwork road_network_;
+    // road_length_prefix_[i] - суммарная длина дорог с номерами 0..i
+    std::vector<double> road_length_prefix_;
     Buildings buildings_;
     double map_default_dogs_speed = 1.0;
     uint64_t map_default_bag_capacity = 3;
     OfficeIdToIndex warehouse_id_to_index_;
     Offices offices_;
+    std::vector<collision_detector::Item> office_items_;
+    collision_detector::ItemIndex office_index_;
     int loot_types_count_;
     std::unordered_map<uint64_t, uint64_t> loot_id_to_value_;
-    size_t player_id_counter_ = 0;
+    size_t session_capacity_ = 0;
 };
 
 class Player {
@@ -286,6 +321,7 @@ public:
     int GetValue() const noexcept { return value_; }
     void SetValue(int value) { value_ = value; }
     void UpdateLootCounter() { if (id_ > loot_counter) { loot_counter = id_; } }
+    void AssignNewId() { id_ = loot_counter++; }
     void SetType(int type) { loot_type_ = type; }
     void SetPos(MapPoint position) { position_ = position; }
 
@@ -297,28 +333,175 @@ private:
     static uint64_t loot_counter;
 };
 
+// Часто изменяемое ("горячее") состояние собаки, которое обновляется на каждом тике
+struct DogState {
+    MapPoint pos{ 0, 0 };
+    MapPoint previous_pos{ 0, 0 }; // предыдущая позиция собаки перед перемещением. Используется для сбора лута в FindGatherEvents
+    MapSpeed speed{ 0, 0 };
+    DIRECTION dir = NORTH;
+    double width = 0.6;
+    double afk_time = 0.0;
+    double play_time = 0.0;
+    size_t corridor = RoadNetwork::NO_CORRIDOR; // коридор дорожной сети, по которому движется собака
+};
+
+/*
+ *  Горячее состояние всех собак сессии в виде структуры массивов (SoA).
+ *  Проходы перемещения, сбора лута и учёта АФК на тике идут по плотным массивам,
+ *  не разыменовывая shared_ptr и не затрагивая имя и рюкзак собаки.
+ *  Слот i во всех массивах принадлежит одной и той же собаке.
+ *  Время бездействия и игры набегает лениво: afk_times и play_times учтены по момент synced_at,
+ *  а всё, что прошло с тех пор по часам сессии clock, добавляется при чтении.
+ *  Поэтому стоящие собаки на тике не обновляются.
+ *  active_slots - слоты, которые должен обработать событийный тик: движущиеся собаки и
+ *  стоящие без взведённого срока вывода из игры. Остальные собаки событийный тик не затрагивает.
+ */
+struct DogStorage {
+    static constexpr double NOT_ARMED = std::numeric_limits<double>::infinity();
+    static constexpr size_t NOT_ACTIVE = std::numeric_limits<size_t>::max();
+
+    std::vector<MapPoint> positions;
+    std::vector<MapPoint> previous_positions;
+    std::vector<MapSpeed> speeds;
+    std::vector<DIRECTION> directions;
+    std::vector<double> widths;
+    std::vector<double> afk_times;
+    std::vector<double> play_times;
+    std::vector<size_t> corridors;
+    std::vector<double> synced_at;
+    std::vector<double> deadlines; // момент вывода из игры по бездействию или NOT_ARMED
+    std::vector<size_t> active_index; // позиция слота в active_slots или NOT_ACTIVE
+
+    std::vector<size_t> active_slots;
+    double clock = 0.0; // время сессии, с
+
+    size_t Size() const noexcept { return positions.size(); }
+
+    size_t Add(const DogState& state) {
+        positions.push_back(state.pos);
+        previous_positions.push_back(state.previous_pos);
+        speeds.push_back(state.speed);
+        directions.push_back(state.dir);
+        widths.push_back(state.width);
+        afk_times.push_back(state.afk_time);
+        play_times.push_back(state.play_time);
+        corridors.push_back(state.corridor);
+        synced_at.push_back(clock);
+        deadlines.push_back(NOT_ARMED);
+        active_index.push_back(NOT_ACTIVE);
+        const size_t slot = positions.size() - 1;
+        Activate(slot);
+        return slot;
+    }
+
+    void Activate(size_t slot) {
+        if (active_index[slot] == NOT_ACTIVE) {
+            active_index[slot] = active_slots.size();
+            active_slots.push_back(slot);
+        }
+    }
+    void Deactivate(size_t slot) {
+        const size_t idx = active_index[slot];
+        if (idx == NOT_ACTIVE) {
+            return;
+        }
+        const size_t last = active_slots.back();
+        active_slots[idx] = last;
+        active_index[last] = idx;
+        active_slots.pop_back();
+        active_index[slot] = NOT_ACTIVE;
+    }
+
+    DogState Get(size_t slot) const {
+        return { positions[slot], previous_positions[slot], speeds[slot], directions[slot],
+                 widths[slot], AfkTime(slot), PlayTime(slot), corridors[slot] };
+    }
+
+    double AfkTime(size_t slot) const { return afk_times[slot] + (clock - synced_at[slot]); }
+    double PlayTime(size_t slot) const { return play_times[slot] + (clock - synced_at[slot]); }
+
+    // Переносит набежавшее время в afk_times и play_times
+    void Sync(size_t slot) {
+        const double elapsed = clock - synced_at[slot];
+        afk_times[slot] += elapsed;
+        play_times[slot] += elapsed;
+        synced_at[slot] = clock;
+    }
+
+    // Удаляет слот, перенося на его место последний, чтобы массивы оставались плотными
+    void Remove(size_t slot) {
+        Deactivate(slot);
+        const auto swap_pop = [slot](auto& column) {
+            column[slot] = column.back();
+            column.pop_back();
+        };
+        swap_pop(positions);
+        swap_pop(previous_positions);
+        swap_pop(speeds);
+        swap_pop(directions);
+        swap_pop(widths);
+        swap_pop(afk_times);
+        swap_pop(play_times);
+        swap_pop(corridors);
+        swap_pop(synced_at);
+        swap_pop(deadlines);
+        swap_pop(active_index);
+        if (slot < Size() && active_index[slot] != NOT_ACTIVE) {
+            active_slots[active_index[slot]] = slot;
+        }
+    }
+};
+
+// Перемещает собаку по дорожной сети карты. Возвращает true, если собака упёрлась в край дороги и остановилась
+inline bool MoveAlongRoads(const RoadNetwork& network, double time, MapPoint& pos, MapPoint& previous_pos, MapSpeed& speed, size_t& corridor) {
+    previous_pos = pos;
+
+    // Коридор ищем заново только если собака ещё не привязана к дороге или оказалась вне её
+    // (например, после восстановления состояния или телепортации)
+    if (corridor == RoadNetwork::NO_CORRIDOR || !network.Contains(corridor, pos.x, pos.y)) {
+        corridor = network.Locate(pos.x, pos.y, speed.dx != 0);
+    }
+    if (corridor == RoadNetwork::NO_CORRIDOR) {
+        return false;
+    }
+
+    const bool at_bound = network.Advance(corridor, pos.x, pos.y, speed.dx, speed.dy, time);
+
+    if (at_bound) {
+        speed = { 0,0 };
+    }
+    return at_bound;
+}
+
+/*
+ *  Собака. Хранит "холодные" данные (имя, рюкзак, очки), а горячее состояние DogState -
+ *  либо у себя, либо, пока собака находится в игровой сессии, в DogStorage этой сессии.
+ */
 class Dog {
 public:
     Dog() {
         id_ = dog_counter++;
         name_ = "Dog_";
         name_.append(std::to_string(id_));
-        pos_.x = 0;
-        pos_.y = 0;
-        speed_.dx = 0;
-        speed_.dy = 0;
-        dir_ = NORTH;
     }
     Dog(std::string name) {
         id_ = dog_counter++;
         name_ = name;
         name_.append("_" + std::to_string(id_));
-        pos_.x = 0;
-        pos_.y = 0;
-        speed_.dx = 0;
-        speed_.dy = 0;
-        dir_ = NORTH;
     }
+
+    // Копия собаки всегда получает собственное состояние и не привязана к сессии
+    Dog(const Dog& other)
+        : id_(other.id_)
+        , name_(other.name_)
+        , movement_speed_(other.movement_speed_)
+        , lootbag_(other.lootbag_)
+        , lootbag_capacity_(other.lootbag_capacity_)
+        , score_(other.score_)
+        , state_(other.GetState()) {
+    }
+    Dog& operator=(const Dog&) = delete;
+
     std::string GetName() const noexcept {
         return name_;
     }
@@ -328,27 +511,28 @@ public:
     }
 
     const MapPoint& GetPosition() const {
-        return pos_;
+        return Column(&DogStorage::positions, &DogState::pos);
     }
     const MapPoint& GetPreviousPosition() const {
-        return previous_pos_;
+        return Column(&DogStorage::previous_positions, &DogState::previous_pos);
     }
 
     const MapSpeed& GetSpeed() const {
-        return speed_;
+        return Column(&DogStorage::speeds, &DogState::speed);
     }
 
     std::string GetDirectionString() const {
-        if (dir_ == DIRECTION::WEST) {
+        const DIRECTION dir = GetDir();
+        if (dir == DIRECTION::WEST) {
             return "L";
         }
-        if (dir_ == DIRECTION::EAST) {
+        if (dir == DIRECTION::EAST) {
             return "R";
         }
-        if (dir_ == DIRECTION::NORTH) {
+        if (dir == DIRECTION::NORTH) {
             return "U";
         }
-        if (dir_ == DIRECTION::SOUTH) {
+        if (dir == DIRECTION::SOUTH) {
             return "D";
         }
         return "";
@@ -363,42 +547,48 @@ public:
     }
     
     void SetPos(MapPoint point) {
-        pos_.x = std::round(point.x * 100.0) / 100.0;
-        pos_.y = std::round(point.y * 100.0) / 100.0;
+        MapPoint& pos = Column(&DogStorage::positions, &DogState::pos);
+        pos.x = std::round(point.x * 100.0) / 100.0;
+        pos.y = std::round(point.y * 100.0) / 100.0;
+        Activate();
     }
     
     void SetPreviousPos(MapPoint point) {
-        previous_pos_.x = std::round(point.x * 100.0) / 100.0;
-        previous_pos_.y = std::round(point.y * 100.0) / 100.0;
+        MapPoint& previous_pos = Column(&DogStorage::previous_positions, &DogState::previous_pos);
+        previous_pos.x = std::round(point.x * 100.0) / 100.0;
+        previous_pos.y = std::round(point.y * 100.0) / 100.0;
     }
 
     void SetDirection(const std::string& direction) {
+        DIRECTION& dir = Column(&DogStorage::directions, &DogState::dir);
+        MapSpeed& speed = Column(&DogStorage::speeds, &DogState::speed);
         if (direction == "L") {
-            dir_ = DIRECTION::WEST;
-            speed_ = { -movement_speed_, 0 };
+            dir = DIRECTION::WEST;
+            speed = { -movement_speed_, 0 };
         }
         else if (direction == "R") {
-            dir_ = DIRECTION::EAST;
-            speed_ = { movement_speed_, 0 };
+            dir = DIRECTION::EAST;
+            speed = { movement_speed_, 0 };
         }
         else if (direction == "U") {
-            dir_ = DIRECTION::NORTH;
-            speed_ = { 0, -movement_speed_ };
+            dir = DIRECTION::NORTH;
+            speed = { 0, -movement_speed_ };
         }
         else if (direction == "D") {
-            dir_ = DIRECTION::SOUTH;
-            speed_ = { 0, movement_speed_ };
+            dir = DIRECTION::SOUTH;
+            speed = { 0, movement_speed_ };
         }
         else {
-            speed_ = { 0, 0 };
+            speed = { 0, 0 };
         }
+        Activate();
     }
 
     void SetMovementSpeed(double x) { movement_speed_ = x; }
     
     void SetBagCapacity(uint64_t x) { lootbag_capacity_ = x; }
 
-    void SetWidth(double x) { width_ = x; }
+    void SetWidth(double x) { Column(&DogStorage::widths, &DogState::width) = x; }
 
     void UpdateDogCounter() {
         if (id_ > dog_counter) {
@@ -406,113 +596,16 @@ public:
         }
     }
 
-    void Move(double time, const Map::Roads& roads) {
-
-        previous_pos_ = pos_;
-
-        double already_traveled = 0.0;
-
-        bool at_bound = false;
-
-        for (const auto& road : roads) {
-            if (road.IsHorizontal()) {
-                double road_start_x = std::min(road.GetStart().x, road.GetEnd().x);
-                double road_end_x = std::max(road.GetStart().x, road.GetEnd().x);
-                double road_y = road.GetStart().y;
-
-                if (std::abs(pos_.y - road_y) <= ROAD_RADIUS && pos_.x >= road_start_x - ROAD_RADIUS && pos_.x <= road_end_x + ROAD_RADIUS) {
-
-                    if (speed_.dx > 0) {
-                        double distance = std::min(pos_.x - already_traveled + speed_.dx * time, road_end_x + ROAD_RADIUS);
-                        pos_.x = distance;
-                        
-                        if (distance >= road_end_x + ROAD_RADIUS) {
-                            at_bound = true; 
-                            speed_.dx = 0;
-                        }
-                        else { at_bound = false; }
-                        break;
-                    }
-                    else if (speed_.dx < 0) {
-                        double distance = std::max(pos_.x - already_traveled + speed_.dx * time, road_start_x - ROAD_RADIUS);
-                        pos_.x = distance;
-
-                        if (distance <= road_start_x - ROAD_RADIUS) {
-                            at_bound = true; 
-                            speed_.dx = 0;
-                        }
-                        else { at_bound = false; }
-                        break;
-                    }
-
-                    else if (speed_.dy != 0) {
-                        double distance = pos_.y + speed_.dy * time;
-                        double start_pos = pos_.y;
-                        if (std::abs(distance) <= road_y + ROAD_RADIUS) {
-                            pos_.y = distance;
-                            at_bound = false; 
-                        }
-                        else {
-                            speed_.dy < 0 ? pos_.y = road_y -ROAD_RADIUS : pos_.y = road_y + ROAD_RADIUS;
-                            at_bound = true;
-                        }
-                        already_traveled = pos_.y - start_pos;
-                    }
-                }
-            }
-            else if (road.IsVertical()) {
-                double road_start_y = std::min(road.GetStart().y, road.GetEnd().y);
-                double road_end_y = std::max(road.GetStart().y, road.GetEnd().y);
-                double road_x = road.GetStart().x;
-
-                // Проверка находится ли собака в пределах дороги
-                if (std::abs(pos_.x - road_x) <= ROAD_RADIUS && pos_.y >= road_start_y - ROAD_RADIUS && pos_.y <= road_end_y + ROAD_RADIUS) {
-
-                    if (speed_.dy > 0) {
-                        double distance = std::min(pos_.y - already_traveled + speed_.dy * time, road_end_y + ROAD_RADIUS);
-                        pos_.y = distance;
-
-                        if (distance >= road_end_y + ROAD_RADIUS) {
-                            at_bound = true; 
-                            speed_.dy = 0;
-                        }
-                        else { at_bound = false; }
-                        break;
-                    }
-                    else if (speed_.dy < 0) {
-                        double distance = std::max(pos_.y - already_traveled + speed_.dy * time, road_start_y - ROAD_RADIUS);
-                        pos_.y = distance;
-                        if (distance <= road_start_y - ROAD_RADIUS) {
-                            at_bound = true;
-                            speed_.dy = 0;
-                        }
-                        else { at_bound = false; }
-                        break;
-                    }
-                   
-                    else if (speed_.dx != 0) {
-                        double distance = pos_.x + speed_.dx * time;
-                        double start_pos = pos_.x;
-                        if (std::abs(distance) <= road_x + ROAD_RADIUS) {
-                            pos_.x = distance;
-                            at_bound = false; 
-                        }
-                        else {
-                            speed_.dx < 0 ? pos_.x = road_x - ROAD_RADIUS : pos_.x = road_x + ROAD_RADIUS;
-                            at_bound = true;
-                        }
-                        already_traveled = pos_.x - start_pos;
-                    }
-                }
-            }
-        }
-        
-        if (at_bound) {
-            speed_ = { 0,0 };
-        }
+    void Move(double time, const Map& map) {
+        MoveAlongRoads(map.GetRoadNetwork(), time,
+            Column(&DogStorage::positions, &DogState::pos),
+            Column(&DogStorage::previous_positions, &DogState::previous_pos),
+            Column(&DogStorage::speeds, &DogState::speed),
+            Column(&DogStorage::corridors, &DogState::corridor));
+        Activate();
     }
 
-    double GetWidth() const { return width_; }
+    double GetWidth() const { return Column(&DogStorage::widths, &DogState::width); }
     
     bool AddLoot(LootSharedPtr loot) {
         if (lootbag_capacity_ > lootbag_.size()) {
@@ -531,92 +624,478 @@ public:
     
     size_t GetLootCount() { return lootbag_.size(); }
     
-    Loots GetLootBag() const { return lootbag_; }
+    std::span<const LootSharedPtr> GetLootBag() const noexcept { return lootbag_; }
     
     int GetScore() const { return score_; }
 
     size_t GetLootBagCapacity() const { return lootbag_capacity_; }
 
-    DIRECTION GetDir() const { return dir_; }
+    DIRECTION GetDir() const { return Column(&DogStorage::directions, &DogState::dir); }
 
     double GetMovementSpeed() const { return movement_speed_; }
 
-    void ResetAFKTime() { AFK_time_ = 0.0; }
-    void UpdateAFKTime(double time) { AFK_time_ += time; }
-    double GetAFKTime() const { return AFK_time_; }
+    void ResetAFKTime() { SyncAFKTime(); Column(&DogStorage::afk_times, &DogState::afk_time) = 0.0; }
+    void UpdateAFKTime(double time) { SyncAFKTime(); Column(&DogStorage::afk_times, &DogState::afk_time) += time; }
+    double GetAFKTime() const { return storage_ ? storage_->AfkTime(slot_) : state_.afk_time; }
+
+    void ResetPlaytime() { SyncPlaytime(); Column(&DogStorage::play_times, &DogState::play_time) = 0.0; }
+    void UpdatePlaytime(double time) { SyncPlaytime(); Column(&DogStorage::play_times, &DogState::play_time) += time; }
+    double GetPlaytime() const { return storage_ ? storage_->PlayTime(slot_) : state_.play_time; }
 
-    void ResetPlaytime() { play_time_ = 0.0; }
-    void UpdatePlaytime(double time) { play_time_ += time; }
-    double GetPlaytime() const { return play_time_; }
+    bool IsMoving() const {
+        const MapSpeed& speed = GetSpeed();
+        return speed.dx != 0 || speed.dy != 0;
+    }
 
-    bool IsMoving() const { return speed_.dx != 0 || speed_.dy != 0; }
+    DogState GetState() const { return storage_ ? storage_->Get(slot_) : state_; }
 
 private:
+    friend class GameSession;
+
+    // Поле горячего состояния: из хранилища сессии, если собака в сессии, иначе собственное
+    template <typename T>
+    T& Column(std::vector<T> DogStorage::* column, T DogState::* field) {
+        return storage_ ? (storage_->*column)[slot_] : state_.*field;
+    }
+    template <typename T>
+    const T& Column(std::vector<T> DogStorage::* column, T DogState::* field) const {
+        return storage_ ? (storage_->*column)[slot_] : state_.*field;
+    }
+
+    void SyncPlaytime() {
+        if (storage_) {
+            storage_->Sync(slot_);
+        }
+    }
+    // Взведённый срок вывода из игры рассчитан по старому времени бездействия - сессия взведёт новый
+    void SyncAFKTime() {
+        if (storage_) {
+            storage_->Sync(slot_);
+            storage_->deadlines[slot_] = DogStorage::NOT_ARMED;
+            storage_->Activate(slot_);
+        }
+    }
+    // Движение или срок собаки изменились - событийный тик должен её обработать
+    void Activate() {
+        if (storage_) {
+            storage_->Activate(slot_);
+        }
+    }
+
+    void Attach(DogStorage& storage) {
+        slot_ = storage.Add(state_);
+        storage_ = &storage;
+    }
+    void Detach() {
+        state_ = storage_->Get(slot_);
+        storage_ = nullptr;
+    }
 
     static uint64_t dog_counter;
     std::uint64_t id_;
     std::string name_;
-    MapPoint pos_;
-    MapSpeed speed_;
-    DIRECTION dir_;
     double movement_speed_ = 0;
-    double width_ = 0.6;
     Loots lootbag_;
     size_t lootbag_capacity_ = 3;
     int score_ = 0;
 
-    MapPoint previous_pos_; // переменная для хранения предыдущей позиции собаки перед перемещением. Используется для сбора лута в FindGatherEvents 
-    double AFK_time_ = 0.0;
-    double play_time_ = 0.0;
-    
+    DogState state_;
+    DogStorage* storage_ = nullptr;
+    size_t slot_ = 0;
 };
 
 class GameSession {
 public:
+    using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+    using LootStorage = util::SlotMap<LootSharedPtr>;
+    using LootHandle = LootStorage::Handle;
+
     GameSession(MapSharedPtr map) : map_(map) {}
-    void AddDog(DogSharedPtr dog) { dogs_.push_back(dog); }
-    void AddLoot(LootSharedPtr loot) { loot_.push_back(loot); }
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+    ~GameSession() {
+        // Собаки могут пережить сессию (например, через Player), поэтому возвращаем им их состояние
+        for (const auto& dog : dogs_) {
+            dog->Detach();
+        }
+    }
+
+    // Сколько последних версий помнит журнал удалений. Клиенту, отставшему сильнее, отдаётся полный снимок
+    static constexpr std::uint64_t VERSION_HISTORY = 256;
+
+    // Изменения сессии после версии since
+    struct StateDelta {
+        Dogs changed_dogs; // новые и изменившиеся собаки
+        std::vector<std::uint64_t> removed_dogs;
+        Loots added_loots; // лут после появления не меняется
+        std::vector<std::uint64_t> removed_loots;
+    };
+
+    void AddDog(DogSharedPtr dog) {
+        dog->Attach(dog_storage_);
+        dog_id_to_slot_[dog->GetId()] = dogs_.size();
+        dog_versions_[dog->GetId()] = { MakeDogFingerprint(*dog), version_ + 1 };
+        dogs_.push_back(dog);
+        MarkStateChanged();
+        roster_revision_.fetch_add(1, std::memory_order_acq_rel);
+    }
+    LootHandle AddLoot(LootSharedPtr loot) {
+        loot_versions_[loot->GetId()] = version_ + 1;
+        MarkStateChanged();
+        return loot_.Insert(std::move(loot));
+    }
+    // Генераторы живут вместе с сессией: время без лута накапливается между ходами,
+    // а случайные числа не требуют обращения к источнику энтропии на каждом ходу
+    void InitRandom(std::uint64_t seed, loot_gen::LootGenerator::TimeInterval loot_period, double loot_probability) {
+        random_.Seed(seed);
+        loot_generator_.emplace(loot_period, loot_probability);
+    }
+    util::FastRandom& GetRandom() noexcept { return random_; }
+    loot_gen::LootGenerator& GetLootGenerator() { return loot_generator_.value(); }
+    // Запросы к сессии выполняются последовательно в её strand, а запросы к разным сессиям - параллельно
+    void BindStrand(boost::asio::io_context& ioc) { strand_.emplace(boost::asio::make_strand(ioc)); }
+    const std::optional<Strand>& GetStrand() const noexcept { return strand_; }
     std::uint64_t GetId() const noexcept { return id_; }
     void SetId(std::uint64_t id) { id_ = id; }
     MapSharedPtr GetMap() const noexcept { return map_; }
-    Loots GetLoots() const noexcept { return loot_; }
-    Dogs GetDogs() const noexcept { return dogs_; }
+    std::span<const LootSharedPtr> GetLoots() const noexcept { return loot_.Values(); }
+    // Лут сессии в плотном массиве. Позиция лута в нём меняется при удалении другого лута,
+    // для долговременных ссылок нужен дескриптор из GetLootHandle
+    const LootStorage& GetLootStorage() const noexcept { return loot_; }
+    LootHandle GetLootHandle(size_t idx) const { return loot_.GetHandle(idx); }
+    // Лут по дескриптору или nullptr, если он уже подобран
+    LootSharedPtr GetLoot(LootHandle handle) const {
+        const auto* loot = loot_.Get(handle);
+        return loot ? *loot : nullptr;
+    }
+    size_t GetLootCount() const noexcept { return loot_.Size(); }
+    std::span<const DogSharedPtr> GetDogs() const noexcept { return dogs_; }
+    const DogStorage& GetDogStorage() const noexcept { return dog_storage_; }
     DogSharedPtr GetDog(std::uint64_t dog_id) const {
-        for (auto& d : dogs_) {
-            if (d->GetId() == dog_id) {
-                return d;
+        const auto it = dog_id_to_slot_.find(dog_id);
+        return it != dog_id_to_slot_.end() ? dogs_[it->second] : nullptr;
+    }
+    void UpdateGameSessionCounter() { if (id_ > session_counter) { session_counter = id_; } }
+    void RemoveDog(std::uint64_t dog_id) {
+        const auto it = dog_id_to_slot_.find(dog_id);
+        if (it == dog_id_to_slot_.end()) {
+            return;
+        }
+        const size_t slot = it->second;
+        dog_id_to_slot_.erase(it);
+        dog_versions_.erase(dog_id);
+        removed_dogs_.push_back({ dog_id, version_ + 1 });
+        MarkStateChanged();
+        roster_revision_.fetch_add(1, std::memory_order_acq_rel);
+        dogs_[slot]->Detach();
+        // Последняя собака переезжает в освободившийся слот
+        dog_storage_.Remove(slot);
+        dogs_[slot] = dogs_.back();
+        dogs_.pop_back();
+        if (slot < dogs_.size()) {
+            dogs_[slot]->slot_ = slot;
+            dog_id_to_slot_[dogs_[slot]->GetId()] = slot;
+        }
+    }
+    bool RemoveLoot(LootHandle handle) {
+        const auto* loot = loot_.Get(handle);
+        if (!loot) {
+            return false;
+        }
+        const std::uint64_t loot_id = (*loot)->GetId();
+        loot_versions_.erase(loot_id);
+        removed_loots_.push_back({ loot_id, version_ + 1 });
+        MarkStateChanged();
+        return loot_.Erase(handle);
+    }
+
+    /*
+     * Версия состояния сессии. Растёт на единицу за каждый тик. Изменения между тиками
+     * (вход игроков, их действия) относятся к следующей версии
+     */
+    std::uint64_t GetVersion() const noexcept { return version_; }
+
+    /*
+     * Закрывает текущую версию. Собаки меняются и на тике, и между тиками,
+     * поэтому изменившиеся находятся сравнением с отпечатком на момент прошлой версии.
+     * Лут и удаления отмечаются в момент изменения
+     */
+    void CommitVersion() {
+        const std::uint64_t next_version = version_ + 1;
+        for (const auto& dog : dogs_) {
+            auto& dog_version = dog_versions_[dog->GetId()];
+            const DogFingerprint fingerprint = MakeDogFingerprint(*dog);
+            if (!(fingerprint == dog_version.fingerprint)) {
+                dog_version = { fingerprint, next_version };
             }
         }
-        return nullptr;
+        version_ = next_version;
+        MarkStateChanged();
+
+        const auto forget = [this](std::deque<Removal>& removals) {
+            while (!removals.empty() && removals.front().version + VERSION_HISTORY <= version_) {
+                removals.pop_front();
+            }
+        };
+        forget(removed_dogs_);
+        forget(removed_loots_);
     }
+
     /*
-    std::map <uint64_t, double> GetPlaytimeSheet() const { return dog_id_to_playtime_; }
-    double GetDogPlaytime(uint64_t dog_id) const { return dog_id_to_playtime_.at(dog_id); }
-    void UpdateDogPlayTime(const uint64_t dog_id, double playtime) {
-        dog_id_to_playtime_[dog_id] += playtime;
+     * Ревизия состояния меняется при любом изменении, которое видит клиент, в том числе
+     * между тиками. По ней кэшируются готовые ответы с состоянием сессии
+     */
+    std::uint64_t GetStateRevision() const noexcept { return state_revision_.load(std::memory_order_acquire); }
+    // Отмечает изменение, сделанное в обход методов сессии, например действие игрока.
+    // Вызывается после изменения и может выполняться под разделяемой блокировкой состояния
+    void MarkStateChanged() noexcept { state_revision_.fetch_add(1, std::memory_order_acq_rel); }
+    // Ревизия состава игроков: меняется только при входе и выходе собак, в том числе при восстановлении.
+    // По ней кэшируется список игроков, который не зависит от тиков и действий
+    std::uint64_t GetRosterRevision() const noexcept { return roster_revision_.load(std::memory_order_acquire); }
+
+    // Можно ли восстановить изменения после версии since по журналу
+    bool CanMakeDelta(std::uint64_t since) const noexcept {
+        return since <= version_ && since + VERSION_HISTORY >= version_;
     }
-    void LoadPlaytimeSheet(const std::map <uint64_t, double>& load_data) { dog_id_to_playtime_ = load_data; }
-     void RemoveDog(std::uint64_t dog_id) {
-        dogs_.erase(find(dogs_.begin(), dogs_.end(), GetDog(dog_id)));
-        dog_id_to_playtime_.erase(dog_id);
+
+    // Изменения после версии since. Перед вызовом нужно проверить CanMakeDelta
+    StateDelta MakeDelta(std::uint64_t since) const {
+        StateDelta delta;
+        for (const auto& dog : dogs_) {
+            if (dog_versions_.at(dog->GetId()).version > since) {
+                delta.changed_dogs.push_back(dog);
+            }
+        }
+        for (const auto& loot : loot_.Values()) {
+            if (loot_versions_.at(loot->GetId()) > since) {
+                delta.added_loots.push_back(loot);
+            }
+        }
+        for (const auto& removal : removed_dogs_) {
+            if (removal.version > since) {
+                delta.removed_dogs.push_back(removal.id);
+            }
+        }
+        for (const auto& removal : removed_loots_) {
+            if (removal.version > since) {
+                delta.removed_loots.push_back(removal.id);
+            }
+        }
+        return delta;
     }
-    */
-    void UpdateGameSessionCounter() { if (id_ > session_counter) { session_counter = id_; } }
-    void RemoveDog(std::uint64_t dog_id) {
-        dogs_.erase(find(dogs_.begin(), dogs_.end(), GetDog(dog_id)));
+
+    /*
+     * Перемещает собак и обновляет их таймеры игры и бездействия за время time.
+     * Время стоящих собак набегает по часам сессии, а срок вывода из игры взводится один раз,
+     * когда собака остановилась, поэтому проверка бездействия в CollectRetired стоит O(истёкших сроков)
+     */
+    void AdvanceDogs(double time, double afk_limit) {
+        const auto& network = map_->GetRoadNetwork();
+        auto& s = dog_storage_;
+        const double next_clock = s.clock + time;
+        for (size_t i = 0; i < s.Size(); ++i) {
+            if (s.speeds[i].dx != 0 || s.speeds[i].dy != 0) {
+                s.Sync(i);
+                MoveAlongRoads(network, time, s.positions[i], s.previous_positions[i], s.speeds[i], s.corridors[i]);
+                s.play_times[i] += time;
+                s.afk_times[i] = 0.0;
+                s.synced_at[i] = next_clock;
+                s.deadlines[i] = DogStorage::NOT_ARMED;
+            }
+            else if (s.deadlines[i] == DogStorage::NOT_ARMED) {
+                ArmRetirement(i, s.clock + (afk_limit - s.AfkTime(i)));
+            }
+        }
+        s.clock = next_clock;
     }
-    void RemoveLoot(LootSharedPtr loot) { loot_.erase(std::remove(loot_.begin(), loot_.end(), loot), loot_.end()); }
-    void UpdateSessionPlayersIdCounter() { map_->SetPlayerIdCounter(dogs_.size()); }
 
+    /*
+     * Событийный вариант AdvanceDogs. Обходит только активные слоты хранилища, поэтому
+     * стоящие собаки со взведённым сроком на тике ничего не стоят, а стоимость не зависит от time.
+     * Повернуть собака может только по команде игрока, так что на прямом участке единственное
+     * событие движения - упор в край коридора. Момент упора находится аналитически: с него
+     * начинает копиться время бездействия и отсчитывается срок вывода из игры, а сам вывод -
+     * событие очереди retirement_queue_. Собака со взведённым сроком перестаёт быть активной.
+     * moved_slots[k] - слот сдвинувшейся собаки, move_times[k] - сколько секунд она двигалась
+     */
+    void AdvanceDogsEventDriven(double time, double afk_limit, std::vector<size_t>& moved_slots, std::vector<double>& move_times) {
+        const auto& network = map_->GetRoadNetwork();
+        auto& s = dog_storage_;
+        const double next_clock = s.clock + time;
+        moved_slots.clear();
+        move_times.clear();
+        // Обход с конца: деактивация переносит на место слота последний, уже обработанный
+        for (size_t k = s.active_slots.size(); k-- > 0;) {
+            const size_t i = s.active_slots[k];
+            if (s.speeds[i].dx != 0 || s.speeds[i].dy != 0) {
+                // Собака движется вдоль одной из осей, так что модуль скорости - сумма модулей компонент
+                const double speed = std::abs(s.speeds[i].dx) + std::abs(s.speeds[i].dy);
+                s.Sync(i);
+                const bool stopped = MoveAlongRoads(network, time, s.positions[i], s.previous_positions[i], s.speeds[i], s.corridors[i]);
+                const double distance = std::abs(s.positions[i].x - s.previous_positions[i].x)
+                    + std::abs(s.positions[i].y - s.previous_positions[i].y);
+                const double move_time = stopped ? std::min(time, distance / speed) : time;
+                s.play_times[i] += move_time;
+                s.afk_times[i] = 0.0;
+                s.synced_at[i] = s.clock + move_time;
+                s.deadlines[i] = DogStorage::NOT_ARMED;
+                if (distance > 0.0) {
+                    moved_slots.push_back(i);
+                    move_times.push_back(move_time);
+                }
+                if (!stopped) {
+                    continue;
+                }
+                ArmRetirement(i, s.synced_at[i] + afk_limit);
+            }
+            else if (s.deadlines[i] == DogStorage::NOT_ARMED) {
+                ArmRetirement(i, s.clock + (afk_limit - s.AfkTime(i)));
+            }
+            s.Deactivate(i);
+        }
+        s.clock = next_clock;
+    }
+
+    /*
+     * Снимает с очереди истёкшие сроки и возвращает собак, бездействовавших afk_limit и дольше.
+     * Собаки остаются в сессии - их удаляет вызывающий.
+     * Запись устарела, если собака уже покинула сессию или успела подвигаться
+     * и получила новый срок - такие записи просто отбрасываются
+     */
+    Dogs CollectRetired(double afk_limit) {
+        Dogs retired;
+        auto& s = dog_storage_;
+        while (!retirement_queue_.empty() && retirement_queue_.top().time <= s.clock) {
+            const RetirementDeadline deadline = retirement_queue_.top();
+            retirement_queue_.pop();
+            const auto it = dog_id_to_slot_.find(deadline.dog_id);
+            if (it == dog_id_to_slot_.end() || s.deadlines[it->second] != deadline.time) {
+                continue;
+            }
+            // Игровое время считается до момента вывода, а не до конца тика
+            const size_t slot = it->second;
+            s.play_times[slot] += deadline.time - s.synced_at[slot];
+            s.afk_times[slot] = afk_limit;
+            s.synced_at[slot] = s.clock;
+            s.deadlines[slot] = DogStorage::NOT_ARMED;
+            retired.push_back(dogs_[slot]);
+        }
+        return retired;
+    }
+
+    /*
+     * Перестраивает индекс области видимости по текущим собакам и луту.
+     * Собаки и лут двигаются и появляются только на тике, поэтому индекс,
+     * построенный после тика, верен до следующего. cell_size - нижняя граница размера ячейки
+     */
+    void BuildVisibilityIndex(double cell_size) {
+        const auto& s = dog_storage_;
+        std::vector<collision_detector::Item> dog_items;
+        dog_items.reserve(s.Size());
+        for (size_t i = 0; i < s.Size(); ++i) {
+            dog_items.push_back({ { s.positions[i].x, s.positions[i].y }, 0.0 });
+        }
+        visible_dogs_.assign(dogs_.begin(), dogs_.end());
+        visible_dogs_index_ = collision_detector::ItemIndex(dog_items, cell_size);
+
+        const auto loots = loot_.Values();
+        std::vector<collision_detector::Item> loot_items;
+        loot_items.reserve(loots.size());
+        for (const auto& loot : loots) {
+            loot_items.push_back({ { loot->GetPos().x, loot->GetPos().y }, 0.0 });
+        }
+        visible_loots_.assign(loots.begin(), loots.end());
+        visible_loots_index_ = collision_detector::ItemIndex(loot_items, cell_size);
+        has_visibility_index_ = true;
+    }
+
+    bool HasVisibilityIndex() const noexcept { return has_visibility_index_; }
+
+    // Собаки и лут не дальше radius от center по индексу, построенному BuildVisibilityIndex
+    void CollectVisible(MapPoint center, double radius, Dogs& dogs, Loots& loots) const {
+        std::vector<size_t> ids;
+        visible_dogs_index_.QueryRadius({ center.x, center.y }, radius, ids);
+        for (size_t id : ids) {
+            dogs.push_back(visible_dogs_[id]);
+        }
+        ids.clear();
+        visible_loots_index_.QueryRadius({ center.x, center.y }, radius, ids);
+        for (size_t id : ids) {
+            loots.push_back(visible_loots_[id]);
+        }
+    }
 
 private:
-    Dogs dogs_;
-    Loots loot_;
+    // То, что видит клиент в состоянии игры. Рюкзак сравнивается по хэшу номеров лута
+    struct DogFingerprint {
+        MapPoint pos;
+        MapSpeed speed;
+        DIRECTION dir;
+        size_t bag_hash;
+        int score;
+
+        bool operator==(const DogFingerprint& other) const {
+            return pos.x == other.pos.x && pos.y == other.pos.y
+                && speed.dx == other.speed.dx && speed.dy == other.speed.dy
+                && dir == other.dir && bag_hash == other.bag_hash && score == other.score;
+        }
+    };
+
+    struct DogVersion {
+        DogFingerprint fingerprint;
+        std::uint64_t version = 0; // версия, в которой собака изменилась последний раз
+    };
+
+    struct Removal {
+        std::uint64_t id;
+        std::uint64_t version;
+    };
+
+    static DogFingerprint MakeDogFingerprint(const Dog& dog) {
+        size_t bag_hash = dog.GetLootBag().size();
+        for (const auto& loot : dog.GetLootBag()) {
+            bag_hash = bag_hash * 31 + static_cast<size_t>(loot->GetId());
+        }
+        return { dog.GetPosition(), dog.GetSpeed(), dog.GetDir(), bag_hash, dog.GetScore() };
+    }
+
+    struct RetirementDeadline {
+        double time;
+        std::uint64_t dog_id;
+
+        bool operator>(const RetirementDeadline& other) const { return time > other.time; }
+    };
+
+    void ArmRetirement(size_t slot, double deadline) {
+        dog_storage_.deadlines[slot] = deadline;
+        retirement_queue_.push({ deadline, dogs_[slot]->GetId() });
+    }
+
+    Dogs dogs_; // dogs_[i] - холодные данные собаки из слота i хранилища dog_storage_
+    std::unordered_map<std::uint64_t, size_t> dog_id_to_slot_;
+    DogStorage dog_storage_;
+    std::priority_queue<RetirementDeadline, std::vector<RetirementDeadline>, std::greater<>> retirement_queue_;
+    LootStorage loot_;
+    // Снимок собак и лута на конец тика для запросов области видимости
+    Dogs visible_dogs_;
+    collision_detector::ItemIndex visible_dogs_index_;
+    Loots visible_loots_;
+    collision_detector::ItemIndex visible_loots_index_;
+    bool has_visibility_index_ = false;
+    // Версии состояния для ответов с изменениями
+    std::uint64_t version_ = 0;
+    std::unordered_map<std::uint64_t, DogVersion> dog_versions_;
+    std::unordered_map<std::uint64_t, std::uint64_t> loot_versions_; // номер лута -> версия появления
+    std::deque<Removal> removed_dogs_;
+    std::deque<Removal> removed_loots_;
+    std::atomic<std::uint64_t> state_revision_{ 0 };
+    std::atomic<std::uint64_t> roster_revision_{ 0 };
     MapSharedPtr map_;
+    std::optional<Strand> strand_;
+    util::FastRandom random_;
+    std::optional<loot_gen::LootGenerator> loot_generator_;
     uint64_t session_counter = 0;
     std::uint64_t id_ = 0;
-
-    // std::map <uint64_t, double> dog_id_to_playtime_;
 };
 
 
@@ -627,7 +1106,7 @@ struct LootConfig {
 
 class GameItemGathererProvider : public collision_detector::ItemGathererProvider {
 public:
-    GameItemGathererProvider(const Dogs& dogs, const Loots& loots)
+    GameItemGathererProvider(const DogStorage& dogs, const Loots& loots)
         : dogs_(dogs), loots_(loots) {}
 
     size_t ItemsCount() const override {
@@ -640,24 +1119,23 @@ public:
     }
 
     size_t GatherersCount() const override {
-        return dogs_.size();
+        return dogs_.Size();
     }
 
     collision_detector::Gatherer GetGatherer(size_t idx) const override {
-        const auto& dog = dogs_.at(idx);
-        MapPoint start_pos = dog->GetPreviousPosition();
-        MapPoint end_pos = dog->GetPosition();
-        return { {start_pos.x, start_pos.y}, {end_pos.x, end_pos.y}, (dog->GetWidth()) }; 
+        const MapPoint& start_pos = dogs_.previous_positions[idx];
+        const MapPoint& end_pos = dogs_.positions[idx];
+        return { {start_pos.x, start_pos.y}, {end_pos.x, end_pos.y}, dogs_.widths[idx] }; 
     }
 
 private:
-    const Dogs& dogs_;
+    const DogStorage& dogs_;
     const Loots& loots_;
 };
 
 class GameOfficePassProvider : public collision_detector::ItemGathererProvider {
 public:
-    GameOfficePassProvider(const Dogs& dogs, const Map::Offices& offices)
+    GameOfficePassProvider(const DogStorage& dogs, const Map::Offices& offices)
         : dogs_(dogs), offices_(offices) {}
 
     size_t ItemsCount() const override {
@@ -670,21 +1148,69 @@ public:
     }
 
     size_t GatherersCount() const override {
-        return dogs_.size();
+        return dogs_.Size();
     }
 
     collision_detector::Gatherer GetGatherer(size_t idx) const override {
-        const auto& dog = dogs_.at(idx);
-        MapPoint start_pos = dog->GetPreviousPosition();
-        MapPoint end_pos = dog->GetPosition();
-        return { {start_pos.x, start_pos.y}, {end_pos.x, end_pos.y}, (dog->GetWidth()) };
+        const MapPoint& start_pos = dogs_.previous_positions[idx];
+        const MapPoint& end_pos = dogs_.positions[idx];
+        return { {start_pos.x, start_pos.y}, {end_pos.x, end_pos.y}, dogs_.widths[idx] };
     }
 
 private:
-    const Dogs& dogs_;
+    const DogStorage& dogs_;
     const Map::Offices& offices_;
 };
 
+/*
+ * Отрезки перемещения собак для поиска столкновений. Собака, не сдвинувшаяся с места,
+ * ничего не может подобрать, поэтому в список не попадает: slots[i] - слот хранилища,
+ * к которому относится i-й собиратель
+ */
+inline std::vector<collision_detector::Gatherer> MakeGatherers(const DogStorage& dogs, std::vector<size_t>& slots) {
+    std::vector<collision_detector::Gatherer> gatherers;
+    gatherers.reserve(dogs.Size());
+    slots.clear();
+    slots.reserve(dogs.Size());
+    for (size_t idx = 0; idx < dogs.Size(); ++idx) {
+        const MapPoint& start_pos = dogs.previous_positions[idx];
+        const MapPoint& end_pos = dogs.positions[idx];
+        if (start_pos.x == end_pos.x && start_pos.y == end_pos.y) {
+            continue;
+        }
+        gatherers.push_back({ {start_pos.x, start_pos.y}, {end_pos.x, end_pos.y}, dogs.widths[idx] });
+        slots.push_back(idx);
+    }
+    return gatherers;
+}
+
+// Отрезки перемещения собак из слотов slots: i-й собиратель относится к слоту slots[i]
+inline std::vector<collision_detector::Gatherer> MakeGatherers(const DogStorage& dogs, std::span<const size_t> slots) {
+    std::vector<collision_detector::Gatherer> gatherers;
+    gatherers.reserve(slots.size());
+    for (const size_t idx : slots) {
+        const MapPoint& start_pos = dogs.previous_positions[idx];
+        const MapPoint& end_pos = dogs.positions[idx];
+        gatherers.push_back({ {start_pos.x, start_pos.y}, {end_pos.x, end_pos.y}, dogs.widths[idx] });
+    }
+    return gatherers;
+}
+
+inline std::vector<collision_detector::Item> MakeLootItems(std::span<const LootSharedPtr> loots) {
+    std::vector<collision_detector::Item> items;
+    items.reserve(loots.size());
+    for (const auto& loot : loots) {
+        items.push_back({ {loot->GetPos().x, loot->GetPos().y}, LOOT_RADIUS });
+    }
+    return items;
+}
+
+// Выбор экземпляра сессии для нового игрока, когда на карте их несколько
+enum class SessionPlacement {
+    FILL_FIRST,    // первый по времени создания экземпляр, в котором есть место
+    LEAST_LOADED   // экземпляр с наименьшим количеством собак
+};
+
 class Game {
     public:
         using Maps = std::vector<MapSharedPtr>;
@@ -693,7 +1219,7 @@ class Game {
         void AddMap(Map map);
 
         void Update(std::uint64_t time_delta) { // для ручного управления
-            MovePlayersAndUpdateLoot(time_delta);
+            Advance(time_delta);
 
             passed_time += time_delta;
 
@@ -704,9 +1230,51 @@ class Game {
         }
 
         void Update(std::chrono::milliseconds time_delta) { // для запуска с тикером
-            MovePlayersAndUpdateLoot(time_delta.count());
+            Advance(time_delta.count());
+        }
+
+        /*
+         * Включает моделирование фиксированными шагами длиной step: время из Update копится
+         * и расходуется целыми шагами, остаток переносится на следующий вызов.
+         * max_catch_up_steps ограничивает число шагов за один Update (0 - без ограничения),
+         * время сверх него отбрасывается, чтобы отставший сервер не уходил в спираль догоняния.
+         * step == 0 возвращает моделирование переменным шагом
+         */
+        void SetFixedStep(std::chrono::milliseconds step, unsigned max_catch_up_steps) {
+            fixed_step_ = static_cast<std::uint64_t>(step.count());
+            max_catch_up_steps_ = max_catch_up_steps;
+            accumulated_time_ = 0;
         }
 
+        bool IsFixedStepMode() const noexcept { return fixed_step_ != 0; }
+
+        /*
+         * Событийное перемещение: каждая собака за тик проходит весь путь до остановки сразу,
+         * а столкновения обрабатываются в порядке их наступления. Стоимость тика зависит
+         * от числа событий, а не от его длительности, поэтому режим подходит для больших Update
+         */
+        void SetEventDrivenMovement(bool enabled) noexcept { event_driven_movement_ = enabled; }
+        bool IsEventDrivenMovement() const noexcept { return event_driven_movement_; }
+
+        /*
+         * Радиус области видимости: в состоянии игры игрок получает только собак и лут
+         * не дальше radius от своей собаки. 0 - область видимости не ограничена
+         */
+        void SetAreaOfInterestRadius(double radius) noexcept { area_of_interest_radius_ = radius; }
+        double GetAreaOfInterestRadius() const noexcept { return area_of_interest_radius_; }
+
+        // Профиль тиков. Потокобезопасен и читается без блокировки состояния игры
+        profiling::TickProfiler& GetTickProfiler() const noexcept { return *tick_profiler_; }
+
+        // Доля шага, накопленная, но ещё не смоделированная, в [0, 1).
+        // Клиент может интерполировать положение между предыдущим и текущим шагом
+        double GetInterpolationAlpha() const noexcept {
+            return fixed_step_ != 0 ? static_cast<double>(accumulated_time_) / static_cast<double>(fixed_step_) : 0.0;
+        }
+
+        // Время, отброшенное из-за ограничения числа шагов, мс
+        std::uint64_t GetDroppedTime() const noexcept { return dropped_time_; }
+
         void EnableManualTimeControl() {
             manual_time_control_ = true;
         }
@@ -715,10 +1283,23 @@ class Game {
             return manual_time_control_;
         }
 
+        void SetDefaultSessionCapacity(size_t capacity) { default_session_capacity_ = capacity; }
+
+        size_t GetDefaultSessionCapacity() const noexcept { return default_session_capacity_; }
+
+        void SetSessionPlacement(SessionPlacement placement) { session_placement_ = placement; }
+
         void EnableRandomSpawner() {
             dog_random_spawning_mode_ = true;
         }
 
+        // Задаёт зерно генераторов случайных чисел игры, делая появление лута и собак воспроизводимым.
+        // Должно вызываться до создания или загрузки сессий
+        void SetRandomSeed(std::uint64_t seed) {
+            random_seed_ = seed;
+            spawn_random_.Seed(util::FastRandom::DeriveSeed(random_seed_, SPAWN_RANDOM_STREAM));
+        }
+
         const Maps& GetMaps() const noexcept {
             return maps_;
         }
@@ -738,7 +1319,7 @@ class Game {
 
             // Проверка флага рандомного спавна собаки (задается в консоли при запуске программы)
             if (dog_random_spawning_mode_) {
-                dog->SetPos(GetRandomMapPointOnRoads(map_id));
+                dog->SetPos(GetRandomMapPointOnRoads(map_id, spawn_random_));
             }
             else {
                 dog->SetPos(GetBeginMapPointOnRoads(map_id));
@@ -754,99 +1335,157 @@ class Game {
             player.SetDog(dog);
 
             // Если сессия найдена то добавляем в сессию, если нет - создаем
-            auto it = sessions_.find(map_id);
-            if (it == sessions_.end()) {
-                auto new_session = std::make_shared<GameSession>(std::make_shared<Map>(*map_ptr));
-                new_session->AddDog(dog);
-    
-                new_session->SetId(session_counter_);
-                ++session_counter_;
-                game_sessions_.emplace_back(new_session);
-                sessions_[map_id] = new_session;
+            const auto session = SelectSession(map_id);
+            session->AddDog(dog);
+            player.ChangeSession(session->GetId());
+            dog_id_to_session_id_[dog->GetId()] = player.GetSessionId();
 
-                player.ChangeSession(new_session->GetId());
+            std::lock_guard players_lock{ *players_mutex_ };
+            players_.emplace(player.GetAuthToken(), player);
+        }
 
-            }
-            else {
-                auto& session = it->second;
-                session->AddDog(dog);
-                auto session_id = session->GetId();
-                player.ChangeSession(session_id);
-            }
+        // Номер для нового игрока. Счётчик общий для всей игры: у карты может быть несколько
+        // экземпляров сессии, и номера игроков в них не должны повторяться
+        int NextPlayerId() {
+            return player_id_counter_++;
+        }
 
-            players_.emplace(player.GetAuthToken(), player);
+        // Восстановленные игроки сохраняют свои номера, новые должны получать номера после них
+        void UpdatePlayerIdCounter(const Player& player) {
+            player_id_counter_ = std::max(player_id_counter_, player.GetId() + 1);
+        }
+
+        // Все экземпляры сессий на карте map_id в порядке создания
+        const GameSessions& GetMapSessions(const Map::Id& map_id) const {
+            static const GameSessions no_sessions;
+            const auto it = sessions_.find(map_id);
+            return it != sessions_.end() ? it->second : no_sessions;
         }
 
+        // Указатель остаётся действительным, пока удерживается GetStateMutex(): игроки удаляются только под монопольной блокировкой
         const Player* FindPlayerByToken(const std::string& token) const noexcept {
+            std::shared_lock players_lock{ *players_mutex_ };
             auto it = players_.find(token);
             return it != players_.end() ? &it->second : nullptr;
         }
 
-     
-        GameSessionSharedPtr FindGameSession(std::uint64_t session_id) const noexcept {
+        /*
+         * Блокировка состояния игры. Обработчики запросов к одной сессии берут её совместно
+         * (между собой они упорядочены strand-ом сессии), а операции над всей игрой -
+         * тик, подключение игрока, сохранение - монопольно
+         */
+        std::shared_mutex& GetStateMutex() const noexcept { return *state_mutex_; }
+
+        // Привязывает существующие и будущие сессии к своим strand-ам в ioc
+        void BindIoContext(boost::asio::io_context& ioc) {
+            ioc_ = &ioc;
             for (const auto& session : game_sessions_) {
-                if (session->GetId() == session_id) {
-                    return session;
-                }
+                session->BindStrand(ioc);
             }
-            return nullptr;
+        }
+
+     
+        GameSessionSharedPtr FindGameSession(std::uint64_t session_id) const noexcept {
+            const auto it = session_id_to_session_.find(session_id);
+            return it != session_id_to_session_.end() ? it->second : nullptr;
+        }
+
+        // Сессия, в которой находится собака, или nullptr, если собака выведена из игры
+        GameSessionSharedPtr FindDogSession(std::uint64_t dog_id) const noexcept {
+            const auto it = dog_id_to_session_id_.find(dog_id);
+            return it != dog_id_to_session_id_.end() ? FindGameSession(it->second) : nullptr;
         }
 
         void SetLootConfig(const LootConfig& config) { loot_config_ = config; }
         
         const LootConfig& GetLootConfig() const noexcept { return loot_config_; }
 
+        // Включает параллельное обновление сессий на threads потоках (1 - последовательное обновление)
+        void SetSimulationThreads(unsigned threads) {
+            simulation_pool_ = threads > 1 ? std::make_unique<WorkStealingPool>(threads) : nullptr;
+        }
+
         void MovePlayersAndUpdateLoot(uint64_t tick_time) {
-            double travel_time = tick_time / 1000.0;
-            for (const auto& game_session : game_sessions_) {
-                const auto& current_map_roads = game_session->GetMap()->GetRoads();
-                const auto& current_sessuion_dogs = game_session->GetDogs();
-   
-                for (const auto& dog : current_sessuion_dogs) {
-                    if (dog->IsMoving()) {
-                        dog->Move(travel_time, current_map_roads);
-                        dog->UpdatePlaytime(travel_time);
-                        dog->ResetAFKTime();
-                    } else if (dog->GetAFKTime() + travel_time >= default_afk_time) {
-                        dog->UpdatePlaytime(default_afk_time - dog->GetAFKTime());
-                        dog->UpdateAFKTime(default_afk_time - dog->GetAFKTime());
+            std::vector<SessionTickResult> results(game_sessions_.size());
+
+            if (simulation_pool_ && game_sessions_.size() > 1) {
+                // Самые нагруженные сессии запускаем первыми, чтобы в конце тика не ждать одну большую сессию
+                std::vector<size_t> order(game_sessions_.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+                    return EstimateTickCost(*game_sessions_[lhs]) > EstimateTickCost(*game_sessions_[rhs]);
+                    });
+                simulation_pool_->Run(order, [this, &results, tick_time](size_t idx) {
+                    results[idx] = TickSession(game_sessions_[idx], tick_time);
+                    });
+            }
+            else {
+                for (size_t idx = 0; idx < game_sessions_.size(); ++idx) {
+                    results[idx] = TickSession(game_sessions_[idx], tick_time);
+                }
+            }
+
+            // Изменения, затрагивающие всю игру, применяем последовательно в порядке сессий,
+            // поэтому результат не зависит от количества потоков
+            std::vector<profiling::TickProfiler::SessionSample> samples(game_sessions_.size());
+            for (size_t idx = 0; idx < game_sessions_.size(); ++idx) {
+                const auto& game_session = game_sessions_[idx];
+                auto& phases = results[idx].phases;
+                {
+                    profiling::PhaseTimer timer{ phases, profiling::TickPhase::AFK };
+                    for (const auto& dog : results[idx].retired_dogs) {
                         RemovePlayerAndSaveStats(dog, game_session);
                     }
-                    else {
-                        dog->UpdateAFKTime(travel_time);
-                        dog->UpdatePlaytime(travel_time);
+                }
+                {
+                    profiling::PhaseTimer timer{ phases, profiling::TickPhase::LOOT_GENERATION };
+                    for (const auto& loot : results[idx].new_loot) {
+                        loot->AssignNewId();
+                        game_session->AddLoot(loot);
                     }
-                  
                 }
-                UpdateGatheredLoot(game_session); // Dog содержит в себе инфо о своей предыдущей локации, поэтому tick_time не используется
-                UpdateLoot(game_session, tick_time);
+                samples[idx] = { game_session->GetId(), *game_session->GetMap()->GetId(), phases };
             }
+            tick_profiler_->RecordSessions(samples);
         }
 
- 
-
-        void UpdateGatheredLoot(GameSessionSharedPtr session) {
-            const auto& session_dogs = session->GetDogs();
-            const auto& session_loots = session->GetLoots();
-            const auto& session_offices = session->GetMap()->GetOffices();
-
-            GameItemGathererProvider provider_gatherloot(session_dogs, session_loots);
-            const auto& gather_events = collision_detector::FindGatherEvents(provider_gatherloot);
-
-            GameOfficePassProvider provider_passloot(session_dogs, session_offices);
-            const auto& pass_events = collision_detector::FindGatherEvents(provider_passloot);
+        void UpdateGatheredLoot(GameSessionSharedPtr session, profiling::PhaseDurations& phases) const {
+            using profiling::TickPhase;
+            const auto session_dogs = session->GetDogs();
+            const auto& loot_storage = session->GetLootStorage();
+
+            std::optional<profiling::PhaseTimer> timer;
+            timer.emplace(phases, TickPhase::LOOT_GATHERING);
+            // Отрезки собак общие для обоих поисков, офисы подготовлены картой заранее
+            std::vector<size_t> dog_slots;
+            const auto gatherers = MakeGatherers(session->GetDogStorage(), dog_slots);
+            const auto loot_items = MakeLootItems(loot_storage.Values());
+            const auto& gather_events = collision_detector::FindGatherEvents(gatherers, loot_items);
+
+            // Удаление лута переставляет плотный массив, поэтому события ссылаются на лут через дескрипторы
+            std::vector<GameSession::LootHandle> loot_handles;
+            loot_handles.reserve(loot_items.size());
+            for (size_t idx = 0; idx < loot_items.size(); ++idx) {
+                loot_handles.push_back(session->GetLootHandle(idx));
+            }
 
             for (const auto& event : gather_events) {
-                const auto& dog = session_dogs.at(event.gatherer_id);
-                const auto& loot = session_loots.at(event.item_id);
+                const auto& dog = session_dogs[dog_slots[event.gatherer_id]];
+                const auto handle = loot_handles[event.item_id];
+                const auto loot = session->GetLoot(handle);
+                if (!loot) { // Этот лут уже подобрала собака, оказавшаяся рядом с ним раньше
+                    continue;
+                }
 
                 if (dog->AddLoot(loot)) { // Добавление лута с проверкой вместимости рюкзака
-                    session->RemoveLoot(loot);
+                    session->RemoveLoot(handle);
                 }
             }
-            
+
+            timer.emplace(phases, TickPhase::OFFICE_DROP_OFF);
+            const auto& pass_events = collision_detector::FindGatherEvents(gatherers, session->GetMap()->GetOfficeIndex());
             for (const auto& event : pass_events) {
-                session_dogs.at(event.gatherer_id)->ClearBag();                
+                session_dogs[dog_slots[event.gatherer_id]]->ClearBag();
             }
         }
 
@@ -868,22 +1507,9 @@ class Game {
         }
 
         void UpdateLoot(GameSessionSharedPtr session, std::chrono::milliseconds time_delta) {
-            loot_gen::LootGenerator gen{ std::chrono::milliseconds(static_cast<int>(loot_config_.period_)),
-                                         loot_config_.probability_ };
-            unsigned count_new_loot_to_add = gen.Generate(time_delta,
-                static_cast<unsigned>(session->GetLoots().size()),
-                static_cast<unsigned>(session->GetDogs().size()));
-            std::random_device rd; 
-            std::mt19937 randomiser(rd()); 
-            const auto& current_map = session->GetMap();
-            std::uniform_int_distribution<> dis(0, current_map->GetLootTypesCount() - 1);
-
-            while (count_new_loot_to_add--) {
-                const auto& map_id = session->GetMap()->GetId();
-                MapPoint loot_pos = GetRandomMapPointOnRoads(map_id);
-                int loot_type = dis(randomiser);
-                uint64_t loot_value = current_map->GetLootValueByTypeID(loot_type);
-                session->AddLoot(std::make_shared<Loot>(loot_type, loot_value, loot_pos));
+            for (const auto& loot : GenerateLoot(session, time_delta)) {
+                loot->AssignNewId();
+                session->AddLoot(loot);
             }
         }
 
@@ -923,34 +1549,248 @@ class Game {
         ConnectionPoolPtr GetDBConnectionPool() {
             return pool_;
         }
+
+        // Выводит собаку из игры: сохраняет результат игрока в БД и удаляет его вместе с собакой
+        void RemovePlayerAndSaveStats(DogSharedPtr dog, GameSessionSharedPtr session);
     private:
-        MapPoint GetRandomMapPointOnRoads(const Map::Id& id) {
-            std::random_device rd;
-            size_t map_index = map_id_to_index_[id];
-            size_t number_of_roads = maps_.at(map_index)->GetRoads().size() - 1;
-            std::uniform_int_distribution<int> dist(0, number_of_roads);
-            auto& random_road = maps_[map_index]->GetRoads()[dist(rd)];
+        /*
+         * Экземпляр сессии на карте map_id для нового игрока. Экземпляры, в которых достигнута
+         * вместимость карты, пропускаются, а среди остальных выбор делается по session_placement_.
+         * Если подходящего экземпляра нет, создаётся новый, ссылающийся на общую карту игры.
+         * Пока состояние игры не меняется, повторный вызов возвращает тот же экземпляр
+         */
+        GameSessionSharedPtr SelectSession(const Map::Id& map_id) {
+            auto map_ptr = FindMap(map_id);
+            if (!map_ptr) {
+                throw std::invalid_argument("Map with id " + *map_id + " not found");
+            }
+            const size_t capacity = map_ptr->GetSessionCapacity();
+
+            GameSessionSharedPtr selected;
+            for (const auto& session : GetMapSessions(map_id)) {
+                const size_t load = session->GetDogs().size();
+                if (capacity != 0 && load >= capacity) {
+                    continue;
+                }
+                if (session_placement_ == SessionPlacement::FILL_FIRST) {
+                    return session;
+                }
+                if (!selected || load < selected->GetDogs().size()) {
+                    selected = session;
+                }
+            }
+            if (selected) {
+                return selected;
+            }
 
-            int x1 = random_road.GetStart().x;
-            int y1 = random_road.GetStart().y;
-            int x2 = random_road.GetEnd().x;
-            int y2 = random_road.GetEnd().y;
-            if (x1 > x2) {
-                std::swap(x1, x2);
+            auto new_session = std::make_shared<GameSession>(map_ptr);
+            new_session->SetId(session_counter_);
+            RegisterSession(new_session);
+            return new_session;
+        }
+
+        // Добавляет сессию во все индексы игры и привязывает её к strand, если задан io_context
+        void RegisterSession(const GameSessionSharedPtr& session) {
+            if (ioc_) {
+                session->BindStrand(*ioc_);
+            }
+            session->InitRandom(util::FastRandom::DeriveSeed(random_seed_, session->GetId()),
+                std::chrono::milliseconds(static_cast<int>(loot_config_.period_)), loot_config_.probability_);
+            game_sessions_.push_back(session);
+            sessions_[session->GetMap()->GetId()].push_back(session);
+            session_id_to_session_[session->GetId()] = session;
+            // Восстановленные сессии сохраняют свои id, новые должны получать id после них
+            session_counter_ = std::max(session_counter_, session->GetId() + 1);
+        }
+
+        void Advance(std::uint64_t time_delta) {
+            const auto start = profiling::Clock::now();
+            // В режиме фиксированного шага тик может не сделать ни одного шага: состояние не изменилось,
+            // и новая версия лишь сбросила бы кэши ответов и сократила историю удалений
+            if (AdvanceSimulation(time_delta) > 0) {
+                for (const auto& session : game_sessions_) {
+                    session->CommitVersion();
+                    if (area_of_interest_radius_ > 0.0) {
+                        session->BuildVisibilityIndex(area_of_interest_radius_);
+                    }
+                }
+            }
+            tick_profiler_->RecordTick(std::chrono::duration_cast<profiling::Duration>(profiling::Clock::now() - start));
+        }
+
+        // Возвращает количество выполненных шагов MovePlayersAndUpdateLoot
+        unsigned AdvanceSimulation(std::uint64_t time_delta) {
+            if (fixed_step_ == 0) {
+                MovePlayersAndUpdateLoot(time_delta);
+                return 1;
+            }
+            accumulated_time_ += time_delta;
+            unsigned steps = 0;
+            while (accumulated_time_ >= fixed_step_ && (max_catch_up_steps_ == 0 || steps < max_catch_up_steps_)) {
+                MovePlayersAndUpdateLoot(fixed_step_);
+                accumulated_time_ -= fixed_step_;
+                ++steps;
             }
-            if (y1 > y2) {
-                std::swap(y1, y2);
+            if (accumulated_time_ >= fixed_step_) {
+                dropped_time_ += accumulated_time_ - accumulated_time_ % fixed_step_;
+                accumulated_time_ %= fixed_step_;
             }
-            std::uniform_int_distribution<int> dist_x(x1, x2);
-            std::uniform_int_distribution<int> dist_y(y1, y2);
-            int x_random_at_map = dist_x(rd);
-            int y_random_at_map = dist_y(rd);
+            return steps;
+        }
+
+        // Результат обновления одной сессии, который нужно применить к игре в целом
+        struct SessionTickResult {
+            Dogs retired_dogs;
+            Loots new_loot; // лут без идентификаторов, они выдаются при добавлении в сессию
+            profiling::PhaseDurations phases{};
+        };
 
-            return MapPoint(x_random_at_map, y_random_at_map);
+        static size_t EstimateTickCost(const GameSession& session) {
+            return session.GetDogStorage().Size() * (session.GetLootCount() + session.GetMap()->GetOffices().size() + 1);
         }
 
-        MapPoint GetBeginMapPointOnRoads(const Map::Id& id) {
-            size_t map_index = map_id_to_index_[id];
+        // Обновляет одну сессию. Затрагивает только её состояние, поэтому разные сессии можно обновлять параллельно
+        SessionTickResult TickSession(const GameSessionSharedPtr& session, uint64_t tick_time) const {
+            if (event_driven_movement_) {
+                return TickSessionEventDriven(session, tick_time);
+            }
+            using profiling::TickPhase;
+            SessionTickResult result;
+            {
+                profiling::PhaseTimer timer{ result.phases, TickPhase::MOVEMENT };
+                session->AdvanceDogs(tick_time / 1000.0, default_afk_time);
+            }
+            {
+                profiling::PhaseTimer timer{ result.phases, TickPhase::AFK };
+                result.retired_dogs = session->CollectRetired(default_afk_time);
+                for (const auto& dog : result.retired_dogs) {
+                    session->RemoveDog(dog->GetId());
+                }
+            }
+            UpdateGatheredLoot(session, result.phases); // Dog содержит в себе инфо о своей предыдущей локации, поэтому tick_time не используется
+            {
+                profiling::PhaseTimer timer{ result.phases, TickPhase::LOOT_GENERATION };
+                result.new_loot = GenerateLoot(session, std::chrono::milliseconds(tick_time));
+            }
+            return result;
+        }
+
+        /*
+         * Тик в событийном режиме. Обрабатываются только активные собаки: движущиеся сдвигаются
+         * сразу на весь отрезок до ближайшей остановки, стоящие не затрагиваются. Подбор лута и сдача его в офис обрабатываются в порядке времени:
+         * доля отрезка из collision_detector переводится в секунды движения конкретной собаки.
+         * Собаки выводятся из игры только после сбора, чтобы успеть подобрать лут на своём пути
+         */
+        SessionTickResult TickSessionEventDriven(const GameSessionSharedPtr& session, uint64_t tick_time) const {
+            using profiling::TickPhase;
+            SessionTickResult result;
+            std::vector<size_t> moved_slots;
+            std::vector<double> move_times;
+            {
+                profiling::PhaseTimer timer{ result.phases, TickPhase::MOVEMENT };
+                session->AdvanceDogsEventDriven(tick_time / 1000.0, default_afk_time, moved_slots, move_times);
+            }
+            ApplyGatherEventsInOrder(session, moved_slots, move_times, result.phases);
+            {
+                profiling::PhaseTimer timer{ result.phases, TickPhase::AFK };
+                result.retired_dogs = session->CollectRetired(default_afk_time);
+                for (const auto& dog : result.retired_dogs) {
+                    session->RemoveDog(dog->GetId());
+                }
+            }
+            {
+                profiling::PhaseTimer timer{ result.phases, TickPhase::LOOT_GENERATION };
+                result.new_loot = GenerateLoot(session, std::chrono::milliseconds(tick_time));
+            }
+            return result;
+        }
+
+        // moved_slots и move_times - результат AdvanceDogsEventDriven: в поиске участвуют только сдвинувшиеся собаки
+        void ApplyGatherEventsInOrder(const GameSessionSharedPtr& session, const std::vector<size_t>& moved_slots,
+                                      const std::vector<double>& move_times, profiling::PhaseDurations& phases) const {
+            using profiling::TickPhase;
+            // События лута и офисов обрабатываются вперемешку, поэтому сдаче в офис приписывается только поиск столкновений с офисами
+            profiling::PhaseTimer timer{ phases, TickPhase::LOOT_GATHERING };
+            const auto session_dogs = session->GetDogs();
+            const auto& loot_storage = session->GetLootStorage();
+
+            if (moved_slots.empty()) {
+                return;
+            }
+            const auto gatherers = MakeGatherers(session->GetDogStorage(), moved_slots);
+            const auto loot_items = MakeLootItems(loot_storage.Values());
+            const auto gather_events = collision_detector::FindGatherEvents(gatherers, loot_items);
+            const auto office_start = profiling::Clock::now();
+            const auto pass_events = collision_detector::FindGatherEvents(gatherers, session->GetMap()->GetOfficeIndex());
+            const auto office_time = std::chrono::duration_cast<profiling::Duration>(profiling::Clock::now() - office_start);
+            phases[static_cast<size_t>(TickPhase::OFFICE_DROP_OFF)] += office_time;
+            phases[static_cast<size_t>(TickPhase::LOOT_GATHERING)] -= office_time;
+
+            struct TimedEvent {
+                double time;
+                bool is_office; // при равном времени сначала подбираем лут, затем сдаём рюкзак
+                size_t dog_slot;
+                size_t item_id;
+
+                bool operator<(const TimedEvent& other) const {
+                    return std::tie(time, is_office, dog_slot, item_id) < std::tie(other.time, other.is_office, other.dog_slot, other.item_id);
+                }
+            };
+            std::vector<TimedEvent> events;
+            events.reserve(gather_events.size() + pass_events.size());
+            for (const auto& event : gather_events) {
+                events.push_back({ event.time * move_times[event.gatherer_id], false, moved_slots[event.gatherer_id], event.item_id });
+            }
+            for (const auto& event : pass_events) {
+                events.push_back({ event.time * move_times[event.gatherer_id], true, moved_slots[event.gatherer_id], event.item_id });
+            }
+            std::sort(events.begin(), events.end());
+
+            std::vector<GameSession::LootHandle> loot_handles;
+            loot_handles.reserve(loot_items.size());
+            for (size_t idx = 0; idx < loot_items.size(); ++idx) {
+                loot_handles.push_back(session->GetLootHandle(idx));
+            }
+
+            for (const auto& event : events) {
+                const auto& dog = session_dogs[event.dog_slot];
+                if (event.is_office) {
+                    dog->ClearBag();
+                    continue;
+                }
+                const auto handle = loot_handles[event.item_id];
+                const auto loot = session->GetLoot(handle);
+                if (loot && dog->AddLoot(loot)) {
+                    session->RemoveLoot(handle);
+                }
+            }
+        }
+
+        Loots GenerateLoot(const GameSessionSharedPtr& session, std::chrono::milliseconds time_delta) const {
+            unsigned count_new_loot_to_add = session->GetLootGenerator().Generate(time_delta,
+                static_cast<unsigned>(session->GetLootCount()),
+                static_cast<unsigned>(session->GetDogs().size()));
+            auto& randomiser = session->GetRandom();
+            const auto& current_map = session->GetMap();
+            std::uniform_int_distribution<> dis(0, current_map->GetLootTypesCount() - 1);
+
+            Loots new_loot;
+            while (count_new_loot_to_add--) {
+                MapPoint loot_pos = current_map->GetRandomPointOnRoads(randomiser);
+                int loot_type = dis(randomiser);
+                uint64_t loot_value = current_map->GetLootValueByTypeID(loot_type);
+                auto loot = std::make_shared<Loot>(loot_type, loot_value);
+                loot->SetPos(loot_pos);
+                new_loot.push_back(std::move(loot));
+            }
+            return new_loot;
+        }
+
+        MapPoint GetRandomMapPointOnRoads(const Map::Id& id, util::FastRandom& rd) const {
+            return maps_.at(map_id_to_index_.at(id))->GetRandomPointOnRoads(rd);
+        }
+        MapPoint GetBeginMapPointOnRoads(const Map::Id& id) const {
+            size_t map_index = map_id_to_index_.at(id);
             size_t number_of_roads = maps_.at(map_index)->GetRoads().size() - 1;
             auto& test_road = maps_[map_index]->GetRoads()[0];
             return MapPoint(test_road.GetStart().x, test_road.GetStart().y);
@@ -966,18 +1806,39 @@ class Game {
         std::unordered_map<std::string, Player> players_;
 
         GameSessions game_sessions_;
-        std::unordered_map<Map::Id, GameSessionSharedPtr, MapIdHasher> sessions_;
+        std::unordered_map<Map::Id, GameSessions, MapIdHasher> sessions_; // экземпляры сессий каждой карты
+        std::unordered_map<std::uint64_t, GameSessionSharedPtr> session_id_to_session_;
         
         LootConfig loot_config_;
 
         std::unordered_map <uint64_t, uint64_t> dog_id_to_session_id_;
 
         std::uint64_t session_counter_ = 0;
+        int player_id_counter_ = 0;
         double default_dog_speed = 1.0;
         uint64_t default_lootbag_capacity = 3;
         double default_afk_time = 60;
 
         bool dog_random_spawning_mode_ = false;
+
+        // Моделирование фиксированным шагом (fixed_step_ == 0 - переменным), все времена в мс
+        std::uint64_t fixed_step_ = 0;
+        unsigned max_catch_up_steps_ = 0;
+        std::uint64_t accumulated_time_ = 0;
+        std::uint64_t dropped_time_ = 0;
+        bool event_driven_movement_ = false;
+        double area_of_interest_radius_ = 0.0;
+        // Как и мьютексы, хранится по указателю, чтобы Game оставалась перемещаемой
+        std::unique_ptr<profiling::TickProfiler> tick_profiler_ = std::make_unique<profiling::TickProfiler>();
+
+        size_t default_session_capacity_ = 0;
+        SessionPlacement session_placement_ = SessionPlacement::FILL_FIRST;
+
+        // Номер потока случайных чисел для появления собак. Потоки сессий нумеруются их id
+        static constexpr std::uint64_t SPAWN_RANDOM_STREAM = std::numeric_limits<std::uint64_t>::max();
+        // Без явного зерна оно один раз берётся из источника энтропии при создании игры
+        std::uint64_t random_seed_ = (static_cast<std::uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+        util::FastRandom spawn_random_{ util::FastRandom::DeriveSeed(random_seed_, SPAWN_RANDOM_STREAM) };
         bool manual_time_control_ = false;
 
         // ДЛЯ СОХРАНЕНИЯ СОСТОЯНИЯ
@@ -986,6 +1847,12 @@ class Game {
         int64_t save_period = 0;
         // ДЛЯ СОХРАНЕНИЯ РЕЙТИНГА
         ConnectionPoolPtr pool_;
+        // ДЛЯ ПАРАЛЛЕЛЬНОГО ОБНОВЛЕНИЯ СЕССИЙ
+        std::unique_ptr<WorkStealingPool> simulation_pool_;
+        // ДЛЯ ПАРАЛЛЕЛЬНОЙ ОБРАБОТКИ ЗАПРОСОВ (мьютексы в unique_ptr, чтобы Game оставался перемещаемым)
+        boost::asio::io_context* ioc_ = nullptr;
+        std::unique_ptr<std::shared_mutex> state_mutex_ = std::make_unique<std::shared_mutex>();
+        std::unique_ptr<std::shared_mutex> players_mutex_ = std::make_unique<std::shared_mutex>();
 
     };
 
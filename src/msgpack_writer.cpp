@@ -0,0 +1,157 @@
+#include "msgpack_writer.h"
+
+#include <bit>
+#include <limits>
+
+namespace msgpack {
+
+void Writer::BigEndian(std::uint64_t value, size_t bytes) {
+    for (size_t i = bytes; i-- > 0;) {
+        Byte(static_cast<std::uint8_t>(value >> (i * 8)));
+    }
+}
+
+void Writer::Header(size_t size, std::uint8_t fix_tag, std::uint8_t fix_limit, std::uint8_t tag16, std::uint8_t tag32) {
+    if (size < fix_limit) {
+        Byte(static_cast<std::uint8_t>(fix_tag | size));
+    }
+    else if (size <= std::numeric_limits<std::uint16_t>::max()) {
+        Byte(tag16);
+        BigEndian(size, 2);
+    }
+    else {
+        Byte(tag32);
+        BigEndian(size, 4);
+    }
+}
+
+void Writer::MapHeader(size_t size) {
+    Header(size, 0x80, 16, 0xde, 0xdf);
+}
+
+void Writer::ArrayHeader(size_t size) {
+    Header(size, 0x90, 16, 0xdc, 0xdd);
+}
+
+void Writer::Nil() {
+    Byte(0xc0);
+}
+
+void Writer::Bool(bool value) {
+    Byte(value ? 0xc3 : 0xc2);
+}
+
+void Writer::UInt(std::uint64_t value) {
+    if (value < 0x80) {
+        Byte(static_cast<std::uint8_t>(value));
+    }
+    else if (value <= std::numeric_limits<std::uint8_t>::max()) {
+        Byte(0xcc);
+        BigEndian(value, 1);
+    }
+    else if (value <= std::numeric_limits<std::uint16_t>::max()) {
+        Byte(0xcd);
+        BigEndian(value, 2);
+    }
+    else if (value <= std::numeric_limits<std::uint32_t>::max()) {
+        Byte(0xce);
+        BigEndian(value, 4);
+    }
+    else {
+        Byte(0xcf);
+        BigEndian(value, 8);
+    }
+}
+
+void Writer::Int(std::int64_t value) {
+    if (value >= 0) {
+        UInt(static_cast<std::uint64_t>(value));
+    }
+    else if (value >= -32) {
+        Byte(static_cast<std::uint8_t>(value)); // negative fixint
+    }
+    else if (value >= std::numeric_limits<std::int8_t>::min()) {
+        Byte(0xd0);
+        BigEndian(static_cast<std::uint64_t>(value), 1);
+    }
+    else if (value >= std::numeric_limits<std::int16_t>::min()) {
+        Byte(0xd1);
+        BigEndian(static_cast<std::uint64_t>(value), 2);
+    }
+    else if (value >= std::numeric_limits<std::int32_t>::min()) {
+        Byte(0xd2);
+        BigEndian(static_cast<std::uint64_t>(value), 4);
+    }
+    else {
+        Byte(0xd3);
+        BigEndian(static_cast<std::uint64_t>(value), 8);
+    }
+}
+
+void Writer::Float(float value) {
+    Byte(0xca);
+    BigEndian(std::bit_cast<std::uint32_t>(value), 4);
+}
+
+void Writer::Double(double value) {
+    Byte(0xcb);
+    BigEndian(std::bit_cast<std::uint64_t>(value), 8);
+}
+
+void Writer::Str(std::string_view value) {
+    const size_t size = value.size();
+    if (size < 32) {
+        Byte(static_cast<std::uint8_t>(0xa0 | size));
+    }
+    else if (size <= std::numeric_limits<std::uint8_t>::max()) {
+        Byte(0xd9);
+        BigEndian(size, 1);
+    }
+    else if (size <= std::numeric_limits<std::uint16_t>::max()) {
+        Byte(0xda);
+        BigEndian(size, 2);
+    }
+    else {
+        Byte(0xdb);
+        BigEndian(size, 4);
+    }
+    buffer_.append(value);
+}
+
+void Writer::Json(const boost::json::value& value) {
+    switch (value.kind()) {
+    case boost::json::kind::null:
+        Nil();
+        break;
+    case boost::json::kind::bool_:
+        Bool(value.get_bool());
+        break;
+    case boost::json::kind::int64:
+        Int(value.get_int64());
+        break;
+    case boost::json::kind::uint64:
+        UInt(value.get_uint64());
+        break;
+    case boost::json::kind::double_:
+        Double(value.get_double());
+        break;
+    case boost::json::kind::string:
+        Str(value.get_string());
+        break;
+    case boost::json::kind::array:
+        ArrayHeader(value.get_array().size());
+        for (const auto& item : value.get_array()) {
+            Json(item);
+        }
+        break;
+    case boost::json::kind::object:
+        MapHeader(value.get_object().size());
+        for (const auto& [key, item] : value.get_object()) {
+            Str(key);
+            Json(item);
+        }
+        break;
+    }
+}
+
+}  // namespace msgpack
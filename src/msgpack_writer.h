@@ -0,0 +1,49 @@
+#pragma once
+
+#include <boost/json.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace msgpack {
+
+inline constexpr std::string_view CONTENT_TYPE = "application/msgpack";
+
+/*
+ *  Потоковая запись в формате MessagePack без построения промежуточного дерева.
+ *  Целые записываются в самой короткой форме (от 1 до 9 байт), поэтому небольшие
+ *  номера занимают столько же, сколько varint. Размер словарей и массивов
+ *  указывается заранее в заголовке, после чего записываются сами элементы:
+ *  для словаря - попеременно ключ и значение.
+ */
+class Writer {
+public:
+    void MapHeader(size_t size);
+    void ArrayHeader(size_t size);
+
+    void Nil();
+    void Bool(bool value);
+    void UInt(std::uint64_t value);
+    void Int(std::int64_t value);
+    // Координаты передаются в float: точности хватает, а места нужно вдвое меньше
+    void Float(float value);
+    void Double(double value);
+    void Str(std::string_view value);
+
+    // Записывает значение JSON как есть (для данных из конфигурации, например типов лута)
+    void Json(const boost::json::value& value);
+
+    const std::string& Data() const noexcept { return buffer_; }
+    std::string Release() noexcept { return std::move(buffer_); }
+
+private:
+    void Byte(std::uint8_t byte) { buffer_.push_back(static_cast<char>(byte)); }
+    void BigEndian(std::uint64_t value, size_t bytes);
+    void Header(size_t size, std::uint8_t fix_tag, std::uint8_t fix_limit, std::uint8_t tag16, std::uint8_t tag32);
+
+    std::string buffer_;
+};
+
+}  // namespace msgpack
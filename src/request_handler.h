@@ -4,6 +4,11 @@
 #include "model.h"
 #include "logger.h"
 #include "frontend_info.h"
+#include "msgpack_writer.h"
+#include "response_serialization.h"
+#include "websocket_session.h"
+#include "shared_buffer_body.h"
+#include "response_cache.h"
 
 #include <boost/json.hpp>
 #include <boost/asio/ip/tcp.hpp>
@@ -18,6 +23,9 @@
 #include <iostream>
 #include <variant>
 #include <random>
+#include <optional>
+#include <shared_mutex>
+#include <mutex>
 
 namespace http_handler {
 
@@ -30,7 +38,7 @@ namespace http_handler {
     namespace http = beast::http;
 
     // Определяем variant для обработки обоих типов ответа
-    using Response = std::variant<http::response<http::string_body>, http::response<http::file_body>>;
+    using Response = std::variant<http::response<http::string_body>, http::response<http::file_body>, http::response<http_server::SharedBufferBody>>;
 
     template <class SomeRequestHandler>
     class LoggingRequestHandler {
@@ -59,6 +67,11 @@ namespace http_handler {
                     LogRequestSent(ip, response_time_ms, res_file.result_int(), std::string{ res_file[http::field::content_type] });
                     send(std::forward<http::response<http::file_body>>(res_file));
                 }
+                else if (std::holds_alternative<http::response<http_server::SharedBufferBody>>(response)) {
+                    http::response<http_server::SharedBufferBody>& res_shared = std::get<http::response<http_server::SharedBufferBody>>(response);
+                    LogRequestSent(ip, response_time_ms, res_shared.result_int(), std::string{ res_shared[http::field::content_type] });
+                    send(std::move(res_shared));
+                }
                 });
         }
 
@@ -76,16 +89,245 @@ namespace http_handler {
 
         template <typename Body, typename Allocator>
         void operator()(http::request<Body, http::basic_fields<Allocator>>&& req, std::function<void(Response)> callback) {
-            // Все операции, которые могут привести к состоянию гонки, выполняем через strand
-            net::post(strand_, [this, req = std::move(req), callback = std::move(callback)]() mutable {
+            // Статические файлы не затрагивают состояние игры и обрабатываются сразу
+            if (!req.target().starts_with("/api")) {
+                Response response = HandleStaticFileRequest(std::move(req));
+                if (callback) {
+                    callback(std::move(response));
+                }
+                return;
+            }
+
+            // Профиль тиков только читается и защищён собственным мьютексом, поэтому не ждёт strand
+            if (req.target().starts_with("/api/v1/debug/tick-profile")) {
+                Response response = HandleTickProfile(req);
+                if (callback) {
+                    callback(std::move(response));
+                }
+                return;
+            }
+
+            // Запросы к конкретной сессии выполняем в её strand, остальные - в общем strand игры
+            auto session_strand = FindSessionStrand(req);
+            auto handle = [this, req = std::move(req), callback = std::move(callback)]() mutable {
                 Response response = this->HandleRequest(std::move(req));
                 if (callback) {
                     callback(std::move(response));
                 }
+                };
+            if (session_strand) {
+                net::post(*session_strand, std::move(handle));
+            }
+            else {
+                net::post(strand_, std::move(handle));
+            }
+        }
+
+        /*
+         * Переход на WebSocket по адресу WEBSOCKET_TARGET. Игрок авторизуется тем же токеном,
+         * что и в HTTP API: в заголовке Authorization или, так как браузер не может задать заголовок,
+         * в параметре token. Сервер раз в тик присылает по соединению состояние игры,
+         * а клиент присылает действия в том же виде, что и /api/v1/game/player/action
+         */
+        void HandleUpgrade(http::request<http::string_body>&& req, beast::tcp_stream&& stream) {
+            const bool is_game_socket = req.target().starts_with(WEBSOCKET_TARGET);
+            std::string token;
+            if (const auto& auth_header = req[http::field::authorization]; auth_header.starts_with("Bearer ")) {
+                token = std::string(auth_header.substr(7));
+            }
+            else {
+                token = ParseQueryParams(std::string(req.target()))["token"];
+            }
+            bool authorized = false;
+            if (is_game_socket) {
+                std::shared_lock lock{ game.GetStateMutex() };
+                authorized = game.FindPlayerByToken(token) != nullptr;
+            }
+            if (!authorized) {
+                // Отказ отправляется обычным HTTP-ответом, после чего соединение закрывается
+                auto res = std::make_shared<http::response<http::string_body>>(is_game_socket
+                    ? UnknownToken(http::status::unauthorized, "Player token not found")
+                    : ErrorResponseApi(http::status::bad_request, "Bad request"));
+                res->keep_alive(false);
+                auto connection = std::make_shared<beast::tcp_stream>(std::move(stream));
+                http::async_write(*connection, *res, [connection, res](beast::error_code, std::size_t) {
+                    beast::error_code ec;
+                    connection->socket().shutdown(tcp::socket::shutdown_send, ec);
+                    });
+                return;
+            }
+
+            auto socket = std::make_shared<http_server::WebSocketSession>(std::move(stream));
+            {
+                std::lock_guard lock{ subscribers_mutex_ };
+                subscribers_[socket.get()] = { socket, token };
+            }
+            socket->Run(std::move(req),
+                [this, token](std::string message) {
+                    HandleSocketMessage(token, message);
+                },
+                [this, key = socket.get()] {
+                    std::lock_guard lock{ subscribers_mutex_ };
+                    subscribers_.erase(key);
                 });
         }
 
+        /*
+         * Рассылает состояние игры подписчикам WebSocket. Вызывается после каждого тика.
+         * Кадры собираются в strand сессии, как и ответы на запросы её игроков, и не мешают
+         * действиям игроков. Снимок сессии берётся из того же кэша, что и для HTTP-запросов
+         */
+        void PublishState() {
+            std::vector<SocketSubscriber> subscribers;
+            {
+                std::lock_guard lock{ subscribers_mutex_ };
+                for (const auto& [key, subscriber] : subscribers_) {
+                    if (auto socket = subscriber.socket.lock()) {
+                        subscribers.emplace_back(std::move(socket), subscriber.token);
+                    }
+                }
+            }
+            if (subscribers.empty()) {
+                return;
+            }
+
+            std::unordered_map<model::GameSessionSharedPtr, std::vector<SocketSubscriber>> session_subscribers;
+            {
+                std::shared_lock lock{ game.GetStateMutex() };
+                for (auto& [socket, token] : subscribers) {
+                    const auto* player = game.FindPlayerByToken(token);
+                    if (!player) { // Собака игрока выведена из игры
+                        socket->Close(http_server::websocket::close_code::normal);
+                        continue;
+                    }
+                    if (auto session = game.FindGameSession(player->GetSessionId())) {
+                        session_subscribers[std::move(session)].push_back({ std::move(socket), std::move(token) });
+                    }
+                }
+            }
+
+            for (auto& [session, session_sockets] : session_subscribers) {
+                auto publish = [this, session, session_sockets = std::move(session_sockets)] {
+                    PublishSessionState(session, session_sockets);
+                    };
+                if (session->GetStrand()) {
+                    net::post(*session->GetStrand(), std::move(publish));
+                }
+                else {
+                    net::post(strand_, std::move(publish));
+                }
+            }
+        }
+
     private:
+        static constexpr std::string_view WEBSOCKET_TARGET = "/api/v1/game/ws";
+
+        struct Subscriber {
+            std::weak_ptr<http_server::WebSocketSession> socket;
+            std::string token;
+        };
+
+        using SocketSubscriber = std::pair<std::shared_ptr<http_server::WebSocketSession>, std::string>;
+
+        void PublishSessionState(const model::GameSessionSharedPtr& session, const std::vector<SocketSubscriber>& session_sockets) {
+            std::shared_lock lock{ game.GetStateMutex() };
+            for (const auto& [socket, token] : session_sockets) {
+                const auto* player = game.FindPlayerByToken(token);
+                if (!player) {
+                    continue;
+                }
+                model::Dogs visible_dogs;
+                model::Loots visible_loots;
+                if (CollectPlayerView(session, *player, visible_dogs, visible_loots)) {
+                    socket->Send(std::make_shared<const std::string>(
+                        SerializeGameState(*session, visible_dogs, visible_loots, std::nullopt, nullptr, false)));
+                }
+                else {
+                    socket->Send(GetSessionState(*session, false));
+                }
+            }
+        }
+
+        // Действие игрока выполняется в strand его сессии, как и запрос /api/v1/game/player/action
+        void HandleSocketMessage(const std::string& token, const std::string& message) {
+            boost::system::error_code ec;
+            boost::json::value json_body = boost::json::parse(message, ec);
+            if (ec || !json_body.is_object() || !json_body.as_object().contains("move") || !json_body.as_object().at("move").is_string()) {
+                return;
+            }
+            std::string direction = std::string(json_body.as_object().at("move").as_string());
+
+            std::optional<model::GameSession::Strand> session_strand;
+            {
+                std::shared_lock lock{ game.GetStateMutex() };
+                const auto* player = game.FindPlayerByToken(token);
+                if (!player) {
+                    return;
+                }
+                if (const auto session = game.FindGameSession(player->GetSessionId())) {
+                    session_strand = session->GetStrand();
+                }
+            }
+            auto apply = [this, token, direction] {
+                std::shared_lock lock{ game.GetStateMutex() };
+                if (const auto* player = game.FindPlayerByToken(token)) {
+                    player->GetDog()->SetDirection(direction);
+                    if (const auto session = game.FindGameSession(player->GetSessionId())) {
+                        session->MarkStateChanged();
+                    }
+                }
+                };
+            if (session_strand) {
+                net::post(*session_strand, std::move(apply));
+            }
+            else {
+                net::post(strand_, std::move(apply));
+            }
+        }
+
+        // Собаки и лут в области видимости игрока. false, если область видимости не ограничена
+        bool CollectPlayerView(const model::GameSessionSharedPtr& session, const model::Player& player, model::Dogs& dogs, model::Loots& loots) const {
+            const double aoi_radius = game.GetAreaOfInterestRadius();
+            if (aoi_radius <= 0.0 || !session->HasVisibilityIndex()) {
+                return false;
+            }
+            const auto player_dog = player.GetDog();
+            session->CollectVisible(player_dog->GetPosition(), aoi_radius, dogs, loots);
+            // Собака, присоединившаяся после последнего тика, ещё не попала в индекс
+            if (std::find(dogs.begin(), dogs.end(), player_dog) == dogs.end()) {
+                dogs.push_back(player_dog);
+            }
+            return true;
+        }
+
+        static bool IsSessionRequest(std::string_view target) {
+            return target.starts_with("/api/v1/game/players")
+                || target.starts_with("/api/v1/game/state")
+                || target.starts_with("/api/v1/game/player/action");
+        }
+
+        // strand сессии игрока, указанного в токене запроса. Пусто, если запрос не относится к сессии
+        // или токен неизвестен - тогда запрос выполняется в общем strand и сам вернёт ошибку
+        template <typename Body, typename Allocator>
+        std::optional<model::GameSession::Strand> FindSessionStrand(const http::request<Body, http::basic_fields<Allocator>>& req) const {
+            if (!IsSessionRequest(req.target())) {
+                return std::nullopt;
+            }
+            const auto& auth_header = req[http::field::authorization];
+            if (!auth_header.starts_with("Bearer ")) {
+                return std::nullopt;
+            }
+            std::shared_lock lock{ game.GetStateMutex() };
+            const auto* player = game.FindPlayerByToken(std::string(auth_header.substr(7)));
+            if (!player) {
+                return std::nullopt;
+            }
+            const auto session = game.FindGameSession(player->GetSessionId());
+            if (!session) {
+                return std::nullopt;
+            }
+            return session->GetStrand();
+        }
 
         std::unordered_map<std::string, std::string> ParseQueryParams(const std::string& target) {
             std::unordered_map<std::string, std::string> params;
@@ -150,6 +392,7 @@ namespace http_handler {
 
 
         Response HandleJoinGame(const http::request<http::string_body>& req) {
+            std::unique_lock lock{ game.GetStateMutex() };
             try {
                 if (req.method() != http::verb::post) {
                     return NotAllowedExceptPOST(http::status::method_not_allowed, "Only POST method is expected");
@@ -188,7 +431,7 @@ namespace http_handler {
                     return ErrorResponseApi(http::status::not_found, "Map not found");
                 }
 
-                int player_id = map->UpdatePlayerIdCounter(); // Обновляет счетчик игроков на карте и возвращает его
+                int player_id = game.NextPlayerId(); // Номера игроков уникальны во всей игре, а не в сессии
                 std::string auth_token = GenerateAuthToken();  // Генерация уникального токена
                
                 model::Player new_player(player_id, std::string(username), auth_token);
@@ -216,6 +459,7 @@ namespace http_handler {
         }
 
         Response HandleGetPlayers(const http::request<http::string_body>& req) {
+            std::shared_lock lock{ game.GetStateMutex() };
 
             if (req.method() != http::verb::get && req.method() != http::verb::head) {
                 return NotAllowedExceptGET_HEAD(http::status::method_not_allowed, "Only GET and HEAD method is expected");
@@ -235,30 +479,21 @@ namespace http_handler {
 
             // Получаем сессию, где находится игрок
             auto player_current_session = game.FindGameSession(player->GetSessionId());
-            auto dogs_on_map = player_current_session->GetDogs();
-
-            json::array players_array;
-
-            for (const auto dog : dogs_on_map) {
-                players_array.push_back(boost::json::object{
-                    {"name", dog->GetName()}
-                    });
-            }
-
-            // Формируем JSON-ответ
-            boost::json::object response_body;
-            response_body["players"] = std::move(players_array);
-
-            http::response<http::string_body> res{ http::status::ok, req.version() };
-            res.set(http::field::content_type, "application/json");
-            res.set(http::field::cache_control, "no-cache");
-            res.body() = boost::json::serialize(response_body);
-            res.prepare_payload();
-
-            return Response{ std::move(res) };
+            const bool as_msgpack = AcceptsMsgPack(req);
+
+            // Список игроков меняется редко, а запрашивается всеми игроками сессии
+            auto body = state_cache_.Get(player_current_session->GetId(),
+                as_msgpack ? ResponseCache::Kind::PLAYERS_MSGPACK : ResponseCache::Kind::PLAYERS_JSON,
+                player_current_session->GetRosterRevision(),
+                [&] {
+                    const auto dogs = player_current_session->GetDogs();
+                    return as_msgpack ? SerializePlayersMsgPack(dogs) : SerializePlayersJson(dogs);
+                });
+            return CachedResponse(std::move(body), as_msgpack ? msgpack::CONTENT_TYPE : "application/json", req.version());
         }
 
         Response HandleGetGameState(const http::request<http::string_body>& req) {
+            std::shared_lock lock{ game.GetStateMutex() };
 
             if (req.method() != http::verb::get && req.method() != http::verb::head) {
                 return NotAllowedExceptGET_HEAD(http::status::method_not_allowed, "Only GET and HEAD method is expected");
@@ -280,65 +515,107 @@ namespace http_handler {
             // Получаем сессию, где находится игрок
             auto player_current_session = game.FindGameSession(player->GetSessionId());
 
-            // Получаем инфо о собаках
-            auto dogs_on_map = player_current_session->GetDogs();
-
-            boost::json::object players_obj;
-            for (const auto& dog : dogs_on_map) {
-                boost::json::object dog_obj;
-                dog_obj["pos"] = boost::json::array{
-                    dog->GetPosition().x,
-                    dog->GetPosition().y
-                };
-                dog_obj["speed"] = boost::json::array{
-                    dog->GetSpeed().dx,
-                    dog->GetSpeed().dy
-                };
-                dog_obj["dir"] = dog->GetDirectionString();
-
-                boost::json::array dog_lootbag;
-                for (const auto& dog_loot : dog->GetLootBag()) {
-                    boost::json::object loot_obj;
-                    loot_obj[std::to_string(dog_loot->GetId())] = dog_loot->GetType();
-                    dog_lootbag.push_back(loot_obj);
+            // Клиент, запомнивший версию, может запросить только изменения после неё.
+            // Область видимости сдвигается вместе с собакой, поэтому с ней всегда отдаётся полный снимок
+            const auto query_params = ParseQueryParams(std::string(req.target()));
+            std::optional<std::uint64_t> since;
+            if (const auto it = query_params.find("since"); it != query_params.end()) {
+                try {
+                    since = std::stoull(it->second);
                 }
-                dog_obj["bag"] = dog_lootbag;
-
-                dog_obj["score"] = dog->GetScore();
+                catch (const std::exception&) {
+                    return ErrorResponseJsonInvalidArgument(http::status::bad_request, "'since' must be a non-negative integer");
+                }
+            }
 
-                players_obj[std::to_string(dog->GetId())] = std::move(dog_obj);
+            // Отбираем, что отдать клиенту: изменения после since или снимок
+            const bool make_delta = since && game.GetAreaOfInterestRadius() <= 0.0 && player_current_session->CanMakeDelta(*since);
+            const bool as_msgpack = AcceptsMsgPack(req);
+            const std::string_view content_type = as_msgpack ? msgpack::CONTENT_TYPE : "application/json";
+            model::GameSession::StateDelta delta;
+            std::span<const model::DogSharedPtr> dogs_on_map = player_current_session->GetDogs();
+            std::span<const model::LootSharedPtr> loot_on_map = player_current_session->GetLoots();
+            model::Dogs visible_dogs;
+            model::Loots visible_loots;
+            if (make_delta) {
+                delta = player_current_session->MakeDelta(*since);
+                dogs_on_map = delta.changed_dogs;
+                loot_on_map = delta.added_loots;
+            }
+            else if (CollectPlayerView(player_current_session, *player, visible_dogs, visible_loots)) {
+                // Игрок видит только область вокруг своей собаки
+                dogs_on_map = visible_dogs;
+                loot_on_map = visible_loots;
+            }
+            else if (!since) {
+                // Снимок всей сессии одинаков для всех её игроков
+                return CachedResponse(GetSessionState(*player_current_session, as_msgpack), content_type, req.version());
+            }
+
+            const std::optional<bool> full = since ? std::optional<bool>{ !make_delta } : std::nullopt;
+            return SerializedResponse(
+                SerializeGameState(*player_current_session, dogs_on_map, loot_on_map, full, make_delta ? &delta : nullptr, as_msgpack),
+                content_type, req.version());
+        }
 
-            }
+        // Состояние игры в том виде, в котором его получает клиент
+        std::string SerializeGameState(const model::GameSession& session, std::span<const model::DogSharedPtr> dogs, std::span<const model::LootSharedPtr> loots,
+            std::optional<bool> full, const model::GameSession::StateDelta* delta, bool as_msgpack) const {
+            GameStateView state;
+            state.version = session.GetVersion();
+            state.dogs = dogs;
+            state.loots = loots;
+            state.full = full;
+            state.delta = delta;
+            if (game.IsFixedStepMode()) {
+                state.interpolation_alpha = game.GetInterpolationAlpha();
+            }
+            return as_msgpack ? SerializeGameStateMsgPack(state) : SerializeGameStateJson(state);
+        }
 
-            // Получаем инфо о луте
-            auto loot_on_map = player_current_session->GetLoots();
+        // Снимок всей сессии из кэша; строится заново, только если состояние сессии изменилось
+        ResponseCache::Buffer GetSessionState(const model::GameSession& session, bool as_msgpack) {
+            return state_cache_.Get(session.GetId(),
+                as_msgpack ? ResponseCache::Kind::STATE_MSGPACK : ResponseCache::Kind::STATE_JSON,
+                session.GetStateRevision(),
+                [&] { return SerializeGameState(session, session.GetDogs(), session.GetLoots(), std::nullopt, nullptr, as_msgpack); });
+        }
 
-            boost::json::object loots_obj;
-            for (const auto& loot : loot_on_map) {
-                boost::json::object one_loot_obj;
-                one_loot_obj["type"] = boost::json::value(loot->GetType());
-                one_loot_obj["pos"] = boost::json::array{
-                    loot->GetPos().x,
-                    loot->GetPos().y
-                };
-                loots_obj[std::to_string(loot->GetId())] = std::move(one_loot_obj);
-            }
+        // JSON остаётся форматом по умолчанию, MessagePack отдаётся только по явному запросу
+        template <typename Body, typename Allocator>
+        static bool AcceptsMsgPack(const http::request<Body, http::basic_fields<Allocator>>& req) {
+            const auto accept = req[http::field::accept];
+            return accept.find(msgpack::CONTENT_TYPE) != std::string_view::npos
+                || accept.find("application/x-msgpack") != std::string_view::npos;
+        }
 
-            // Формируем JSON-ответ
-            boost::json::object response_body;
-            response_body["players"] = std::move(players_obj);
-            response_body["lostObjects"] = std::move(loots_obj);
+        static Response MsgPackResponse(std::string body, unsigned version) {
+            return SerializedResponse(std::move(body), msgpack::CONTENT_TYPE, version);
+        }
 
-            http::response<http::string_body> res{ http::status::ok, req.version() };
-            res.set(http::field::content_type, "application/json");
+        static Response SerializedResponse(std::string body, std::string_view content_type, unsigned version) {
+            http::response<http::string_body> res{ http::status::ok, version };
+            res.set(http::field::content_type, content_type);
             res.set(http::field::cache_control, "no-cache");
-            res.body() = boost::json::serialize(response_body);
+            res.set(http::field::vary, "Accept");
+            res.body() = std::move(body);
             res.prepare_payload();
+            return Response{ std::move(res) };
+        }
 
+        // Ответ из общего буфера кэша: тело не копируется
+        static Response CachedResponse(ResponseCache::Buffer body, std::string_view content_type, unsigned version) {
+            http::response<http_server::SharedBufferBody> res{ http::status::ok, version };
+            res.set(http::field::content_type, content_type);
+            res.set(http::field::cache_control, "no-cache");
+            res.set(http::field::vary, "Accept");
+            res.body() = std::move(body);
+            res.prepare_payload();
             return Response{ std::move(res) };
         }
 
         Response HandleAction(const http::request<http::string_body>& req) {
+            std::shared_lock lock{ game.GetStateMutex() };
             if (req.method() != http::verb::post) {
                 return NotAllowedExceptPOST(http::status::method_not_allowed, "Only POST method is expected");
             }
@@ -373,6 +650,9 @@ namespace http_handler {
             // Задаем собаке направление
             const auto& current_player_dog = player->GetDog();
             current_player_dog->SetDirection(direction);
+            if (const auto session = game.FindGameSession(player->GetSessionId())) {
+                session->MarkStateChanged();
+            }
 
             // Создаём JSON-ответ с данными игрока
             boost::json::object response_body{
@@ -422,7 +702,11 @@ namespace http_handler {
 
                 // Извлечение параметра и выполнение действий
                 int64_t tick_time = time_delta.as_int64();
-                game.Update(tick_time);
+                {
+                    std::unique_lock lock{ game.GetStateMutex() };
+                    game.Update(tick_time);
+                }
+                PublishState();
 
                 // Формирование успешного ответа
                 boost::json::object response_body{};
@@ -441,6 +725,53 @@ namespace http_handler {
         }
 
 
+        static boost::json::object SerializeTimings(const profiling::RollingWindow::Summary& summary) {
+            const auto to_us = [](profiling::Duration duration) {
+                return std::chrono::duration<double, std::micro>(duration).count();
+            };
+            boost::json::object timings;
+            timings["samples"] = summary.count;
+            timings["p50Us"] = to_us(summary.p50);
+            timings["p99Us"] = to_us(summary.p99);
+            timings["maxUs"] = to_us(summary.max);
+            return timings;
+        }
+
+        template <typename Body, typename Allocator>
+        Response HandleTickProfile(const http::request<Body, http::basic_fields<Allocator>>& req) {
+            if (req.method() != http::verb::get && req.method() != http::verb::head) {
+                return NotAllowedExceptGET_HEAD(http::status::method_not_allowed, "Only GET and HEAD method is expected");
+            }
+
+            const auto report = game.GetTickProfiler().GetReport();
+            boost::json::object profile;
+            profile["tickPeriodMs"] = report.tick_budget.count();
+            profile["ticks"] = report.ticks;
+            profile["overruns"] = report.overruns;
+            profile["tick"] = SerializeTimings(report.tick);
+
+            boost::json::array sessions;
+            for (const auto& session_report : report.sessions) {
+                boost::json::object phases;
+                for (size_t phase = 0; phase < profiling::TICK_PHASE_COUNT; ++phase) {
+                    phases[profiling::GetPhaseName(static_cast<profiling::TickPhase>(phase))] = SerializeTimings(session_report.phases[phase]);
+                }
+                boost::json::object session;
+                session["sessionId"] = session_report.session_id;
+                session["mapId"] = session_report.map_id;
+                session["phases"] = std::move(phases);
+                sessions.push_back(std::move(session));
+            }
+            profile["sessions"] = std::move(sessions);
+
+            http::response<http::string_body> res{ http::status::ok, req.version() };
+            res.set(http::field::cache_control, "no-cache");
+            res.set(http::field::content_type, "application/json");
+            res.body() = boost::json::serialize(profile);
+            res.prepare_payload();
+            return Response{ std::move(res) };
+        }
+
         Response HandleGetMap(const http::request<http::string_body>& req) {
             if (req.method() != http::verb::get && req.method() != http::verb::head) {
                 return NotAllowedExceptGET_HEAD(http::status::method_not_allowed, "Only GET and HEAD method is expected");
@@ -448,12 +779,17 @@ namespace http_handler {
 
             const std::string& map_id = std::string(req.target().substr(13));
             if (const model::MapSharedPtr map = game.FindMap(model::Map::Id(map_id))) {
-                const auto& mapinfo = SerializeMap(map, frontend_information.GetLootInfo(map_id));
+                if (AcceptsMsgPack(req)) {
+                    return MsgPackResponse(SerializeMapMsgPack(*map, frontend_information.GetLootInfo(map_id)), req.version());
+                }
+                const auto& mapinfo = SerializeMapJson(*map, frontend_information.GetLootInfo(map_id));
 
+                http::response<http::string_body> res_string_body;
                 res_string_body.version(11);
                 res_string_body.result(http::status::ok);
                 res_string_body.set(http::field::content_type, "application/json");
                 res_string_body.set(http::field::cache_control, "no-cache");
+                res_string_body.set(http::field::vary, "Accept");
                 res_string_body.body() = mapinfo;
                 res_string_body.prepare_payload();
                 return Response{ std::move(res_string_body) };
@@ -470,6 +806,7 @@ namespace http_handler {
                 maps_array.push_back(map_obj);
             }
 
+            http::response<http::string_body> res_string_body;
             res_string_body.version(11);
             res_string_body.result(http::status::ok);
             res_string_body.set(http::field::content_type, "application/json");
@@ -559,6 +896,7 @@ namespace http_handler {
                 return ErrorResponseStatic(http::status::internal_server_error, "Failed to open file");
             }
 
+            http::response<http::file_body> res_file;
             res_file.version(11);
             res_file.result(http::status::ok);
             res_file.set(http::field::content_type, GetMimeType(full_path.string()));
@@ -577,19 +915,18 @@ namespace http_handler {
         http::response<http::string_body> InvalidToken(http::status status, const std::string& message);
         http::response<http::string_body> UnknownToken(http::status status, const std::string& message);
 
-        std::string SerializeMap(const model::MapSharedPtr map, boost::json::array mapsinfo);
-
-        boost::json::object CreateMapObject(const model::MapSharedPtr map, const boost::json::array& mapsinfo);
-        boost::json::array CreateRoadsArray(const model::MapSharedPtr map);
-        boost::json::array CreateBuildingsArray(const model::MapSharedPtr map);
-        boost::json::array CreateOfficesArray(const model::MapSharedPtr map);
 
 
+        // Общий strand игры для запросов, не относящихся к конкретной сессии (вход в игру, тик, рекорды)
         net::strand<net::io_context::executor_type> strand_;
-        http::response<http::file_body> res_file;
-        http::response<http::string_body> res_string_body;
         model::Game& game;
         rawinfo::FrontendInfo& frontend_information;
         std::string root_dir_;
+
+        // Подписчики WebSocket; ключ - адрес соединения, само соединение ими не удерживается
+        std::mutex subscribers_mutex_;
+        std::unordered_map<const http_server::WebSocketSession*, Subscriber> subscribers_;
+        // Готовые ответы с состоянием сессий, общие для HTTP-запросов и WebSocket
+        ResponseCache state_cache_;
     };
 }
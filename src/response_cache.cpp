@@ -0,0 +1,20 @@
+#include "response_cache.h"
+
+#include <functional>
+
+namespace http_handler {
+
+size_t ResponseCache::KeyHasher::operator()(const Key& key) const noexcept {
+    return std::hash<std::uint64_t>{}(key.session_id) * 31 + static_cast<size_t>(key.kind);
+}
+
+ResponseCache::Entry& ResponseCache::FindEntry(std::uint64_t session_id, Kind kind) {
+    std::lock_guard lock{ entries_mutex_ };
+    auto& entry = entries_[Key{ session_id, kind }];
+    if (!entry) {
+        entry = std::make_unique<Entry>();
+    }
+    return *entry;
+}
+
+}  // namespace http_handler
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace http_handler {
+
+/*
+ *  Кэш готовых ответов с состоянием сессии. Между тиками все игроки сессии получают
+ *  одно и то же, поэтому ответ сериализуется один раз на ревизию состояния
+ *  и дальше раздаётся как общий неизменяемый буфер.
+ *  Одновременные запросы одной записи ждут единственного построения,
+ *  а не сериализуют состояние каждый сам.
+ */
+class ResponseCache {
+public:
+    using Buffer = std::shared_ptr<const std::string>;
+
+    // Ответы с состоянием кэшируются по ревизии состояния сессии, список игроков - по ревизии состава
+    enum class Kind {
+        STATE_JSON,
+        STATE_MSGPACK,
+        PLAYERS_JSON,
+        PLAYERS_MSGPACK
+    };
+
+    /*
+     * Ответ для сессии session_id на ревизии revision. Если в кэше ответ более старой ревизии,
+     * он строится заново вызовом build(), который должен вернуть std::string.
+     * Ответ более новой ревизии тоже подходит: он не отстаёт от запрошенного состояния
+     */
+    template <typename Build>
+    Buffer Get(std::uint64_t session_id, Kind kind, std::uint64_t revision, Build&& build) {
+        Entry& entry = FindEntry(session_id, kind);
+        std::lock_guard lock{ entry.mutex };
+        if (!entry.buffer || entry.revision < revision) {
+            entry.buffer = std::make_shared<const std::string>(build());
+            entry.revision = revision;
+        }
+        return entry.buffer;
+    }
+
+private:
+    struct Entry {
+        std::mutex mutex;
+        std::uint64_t revision = 0;
+        Buffer buffer;
+    };
+
+    struct Key {
+        std::uint64_t session_id;
+        Kind kind;
+
+        bool operator==(const Key& other) const noexcept {
+            return session_id == other.session_id && kind == other.kind;
+        }
+    };
+
+    struct KeyHasher {
+        size_t operator()(const Key& key) const noexcept;
+    };
+
+    // Записи не удаляются, поэтому ссылка на запись остаётся действительной без блокировки
+    Entry& FindEntry(std::uint64_t session_id, Kind kind);
+
+    std::mutex entries_mutex_;
+    std::unordered_map<Key, std::unique_ptr<Entry>, KeyHasher> entries_;
+};
+
+}  // namespace http_handler
@@ -0,0 +1,296 @@
+#include "response_serialization.h"
+#include "msgpack_writer.h"
+
+namespace http_handler {
+
+namespace {
+
+boost::json::object SerializeDogs(std::span<const model::DogSharedPtr> dogs) {
+    boost::json::object players_obj;
+    for (const auto& dog : dogs) {
+        boost::json::object dog_obj;
+        dog_obj["pos"] = boost::json::array{
+            dog->GetPosition().x,
+            dog->GetPosition().y
+        };
+        dog_obj["speed"] = boost::json::array{
+            dog->GetSpeed().dx,
+            dog->GetSpeed().dy
+        };
+        dog_obj["dir"] = dog->GetDirectionString();
+
+        boost::json::array dog_lootbag;
+        for (const auto& dog_loot : dog->GetLootBag()) {
+            boost::json::object loot_obj;
+            loot_obj[std::to_string(dog_loot->GetId())] = dog_loot->GetType();
+            dog_lootbag.push_back(loot_obj);
+        }
+        dog_obj["bag"] = dog_lootbag;
+
+        dog_obj["score"] = dog->GetScore();
+
+        players_obj[std::to_string(dog->GetId())] = std::move(dog_obj);
+    }
+    return players_obj;
+}
+
+boost::json::object SerializeLoots(std::span<const model::LootSharedPtr> loots) {
+    boost::json::object loots_obj;
+    for (const auto& loot : loots) {
+        boost::json::object one_loot_obj;
+        one_loot_obj["type"] = boost::json::value(loot->GetType());
+        one_loot_obj["pos"] = boost::json::array{
+            loot->GetPos().x,
+            loot->GetPos().y
+        };
+        loots_obj[std::to_string(loot->GetId())] = std::move(one_loot_obj);
+    }
+    return loots_obj;
+}
+
+boost::json::array SerializeIds(const std::vector<std::uint64_t>& ids) {
+    boost::json::array ids_array;
+    for (const auto id : ids) {
+        ids_array.push_back(boost::json::value(std::to_string(id)));
+    }
+    return ids_array;
+}
+
+void WriteDogs(msgpack::Writer& writer, std::span<const model::DogSharedPtr> dogs) {
+    writer.MapHeader(dogs.size());
+    for (const auto& dog : dogs) {
+        writer.UInt(dog->GetId());
+        writer.MapHeader(5);
+        writer.Str("pos");
+        writer.ArrayHeader(2);
+        writer.Float(static_cast<float>(dog->GetPosition().x));
+        writer.Float(static_cast<float>(dog->GetPosition().y));
+        writer.Str("speed");
+        writer.ArrayHeader(2);
+        writer.Float(static_cast<float>(dog->GetSpeed().dx));
+        writer.Float(static_cast<float>(dog->GetSpeed().dy));
+        writer.Str("dir");
+        writer.Str(dog->GetDirectionString());
+        writer.Str("bag");
+        const auto bag = dog->GetLootBag();
+        writer.ArrayHeader(bag.size());
+        for (const auto& dog_loot : bag) {
+            writer.MapHeader(1);
+            writer.UInt(dog_loot->GetId());
+            writer.Int(dog_loot->GetType());
+        }
+        writer.Str("score");
+        writer.Int(dog->GetScore());
+    }
+}
+
+void WriteLoots(msgpack::Writer& writer, std::span<const model::LootSharedPtr> loots) {
+    writer.MapHeader(loots.size());
+    for (const auto& loot : loots) {
+        writer.UInt(loot->GetId());
+        writer.MapHeader(2);
+        writer.Str("type");
+        writer.Int(loot->GetType());
+        writer.Str("pos");
+        writer.ArrayHeader(2);
+        writer.Float(static_cast<float>(loot->GetPos().x));
+        writer.Float(static_cast<float>(loot->GetPos().y));
+    }
+}
+
+void WriteIds(msgpack::Writer& writer, const std::vector<std::uint64_t>& ids) {
+    writer.ArrayHeader(ids.size());
+    for (const auto id : ids) {
+        writer.UInt(id);
+    }
+}
+
+boost::json::array SerializeRoads(const model::Map& map) {
+    boost::json::array roads_array;
+    for (const auto& road : map.GetRoads()) {
+        boost::json::object road_obj;
+        road_obj["x0"] = road.GetStart().x;
+        road_obj["y0"] = road.GetStart().y;
+        if (road.IsHorizontal()) {
+            road_obj["x1"] = road.GetEnd().x;
+        }
+        else {
+            road_obj["y1"] = road.GetEnd().y;
+        }
+        roads_array.push_back(std::move(road_obj));
+    }
+    return roads_array;
+}
+
+boost::json::array SerializeBuildings(const model::Map& map) {
+    boost::json::array buildings_array;
+    for (const auto& building : map.GetBuildings()) {
+        boost::json::object building_obj;
+        building_obj["x"] = building.GetBounds().position.x;
+        building_obj["y"] = building.GetBounds().position.y;
+        building_obj["w"] = building.GetBounds().size.width;
+        building_obj["h"] = building.GetBounds().size.height;
+        buildings_array.push_back(std::move(building_obj));
+    }
+    return buildings_array;
+}
+
+boost::json::array SerializeOffices(const model::Map& map) {
+    boost::json::array offices_array;
+    for (const auto& office : map.GetOffices()) {
+        boost::json::object office_obj;
+        office_obj["id"] = *office.GetId();
+        office_obj["x"] = office.GetPosition().x;
+        office_obj["y"] = office.GetPosition().y;
+        office_obj["offsetX"] = office.GetOffset().dx;
+        office_obj["offsetY"] = office.GetOffset().dy;
+        offices_array.push_back(std::move(office_obj));
+    }
+    return offices_array;
+}
+
+}  // namespace
+
+std::string SerializeGameStateJson(const GameStateView& state) {
+    boost::json::object response_body;
+    response_body["version"] = state.version;
+    if (state.full) {
+        response_body["full"] = *state.full;
+    }
+    response_body["players"] = SerializeDogs(state.dogs);
+    response_body["lostObjects"] = SerializeLoots(state.loots);
+    if (state.delta) {
+        response_body["removedPlayers"] = SerializeIds(state.delta->removed_dogs);
+        response_body["removedLostObjects"] = SerializeIds(state.delta->removed_loots);
+    }
+    if (state.interpolation_alpha) {
+        response_body["interpolationAlpha"] = *state.interpolation_alpha;
+    }
+    return boost::json::serialize(response_body);
+}
+
+std::string SerializeGameStateMsgPack(const GameStateView& state) {
+    msgpack::Writer writer;
+    writer.MapHeader(3 + (state.full ? 1 : 0) + (state.delta ? 2 : 0) + (state.interpolation_alpha ? 1 : 0));
+    writer.Str("version");
+    writer.UInt(state.version);
+    if (state.full) {
+        writer.Str("full");
+        writer.Bool(*state.full);
+    }
+    writer.Str("players");
+    WriteDogs(writer, state.dogs);
+    writer.Str("lostObjects");
+    WriteLoots(writer, state.loots);
+    if (state.delta) {
+        writer.Str("removedPlayers");
+        WriteIds(writer, state.delta->removed_dogs);
+        writer.Str("removedLostObjects");
+        WriteIds(writer, state.delta->removed_loots);
+    }
+    if (state.interpolation_alpha) {
+        writer.Str("interpolationAlpha");
+        writer.Double(*state.interpolation_alpha);
+    }
+    return writer.Release();
+}
+
+std::string SerializePlayersJson(std::span<const model::DogSharedPtr> dogs) {
+    boost::json::array players_array;
+    for (const auto& dog : dogs) {
+        players_array.push_back(boost::json::object{
+            {"name", dog->GetName()}
+            });
+    }
+
+    boost::json::object response_body;
+    response_body["players"] = std::move(players_array);
+    return boost::json::serialize(response_body);
+}
+
+std::string SerializePlayersMsgPack(std::span<const model::DogSharedPtr> dogs) {
+    msgpack::Writer writer;
+    writer.MapHeader(1);
+    writer.Str("players");
+    writer.ArrayHeader(dogs.size());
+    for (const auto& dog : dogs) {
+        writer.MapHeader(1);
+        writer.Str("name");
+        writer.Str(dog->GetName());
+    }
+    return writer.Release();
+}
+
+std::string SerializeMapJson(const model::Map& map, const boost::json::array& loot_types) {
+    boost::json::object map_obj;
+    map_obj["id"] = *map.GetId();
+    map_obj["name"] = map.GetName();
+    map_obj["roads"] = SerializeRoads(map);
+    map_obj["buildings"] = SerializeBuildings(map);
+    map_obj["offices"] = SerializeOffices(map);
+    map_obj["lootTypes"] = loot_types;
+    return boost::json::serialize(map_obj);
+}
+
+std::string SerializeMapMsgPack(const model::Map& map, const boost::json::array& loot_types) {
+    msgpack::Writer writer;
+    writer.MapHeader(6);
+    writer.Str("id");
+    writer.Str(*map.GetId());
+    writer.Str("name");
+    writer.Str(map.GetName());
+
+    writer.Str("roads");
+    writer.ArrayHeader(map.GetRoads().size());
+    for (const auto& road : map.GetRoads()) {
+        writer.MapHeader(3);
+        writer.Str("x0");
+        writer.Int(road.GetStart().x);
+        writer.Str("y0");
+        writer.Int(road.GetStart().y);
+        if (road.IsHorizontal()) {
+            writer.Str("x1");
+            writer.Int(road.GetEnd().x);
+        }
+        else {
+            writer.Str("y1");
+            writer.Int(road.GetEnd().y);
+        }
+    }
+
+    writer.Str("buildings");
+    writer.ArrayHeader(map.GetBuildings().size());
+    for (const auto& building : map.GetBuildings()) {
+        writer.MapHeader(4);
+        writer.Str("x");
+        writer.Int(building.GetBounds().position.x);
+        writer.Str("y");
+        writer.Int(building.GetBounds().position.y);
+        writer.Str("w");
+        writer.Int(building.GetBounds().size.width);
+        writer.Str("h");
+        writer.Int(building.GetBounds().size.height);
+    }
+
+    writer.Str("offices");
+    writer.ArrayHeader(map.GetOffices().size());
+    for (const auto& office : map.GetOffices()) {
+        writer.MapHeader(5);
+        writer.Str("id");
+        writer.Str(*office.GetId());
+        writer.Str("x");
+        writer.Int(office.GetPosition().x);
+        writer.Str("y");
+        writer.Int(office.GetPosition().y);
+        writer.Str("offsetX");
+        writer.Int(office.GetOffset().dx);
+        writer.Str("offsetY");
+        writer.Int(office.GetOffset().dy);
+    }
+
+    writer.Str("lootTypes");
+    writer.Json(loot_types);
+    return writer.Release();
+}
+
+}  // namespace http_handler
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "model.h"
+
+#include <boost/json.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace http_handler {
+
+/*
+ *  Ответы API с состоянием игры, списком игроков и картой в двух кодировках:
+ *  JSON (по умолчанию) и MessagePack (по заголовку Accept). Обе кодировки передают
+ *  одни и те же данные. Отличия MessagePack: номера собак и лута записываются числами,
+ *  а не строками, координаты и скорости - в float.
+ */
+
+// Состояние игры, которое получает клиент
+struct GameStateView {
+    std::uint64_t version = 0;
+    std::span<const model::DogSharedPtr> dogs;
+    std::span<const model::LootSharedPtr> loots;
+    // Передаётся клиенту, запросившему изменения после версии: true, если вместо изменений отдан снимок
+    std::optional<bool> full;
+    // Удалённые собаки и лут, если вместо снимка отдаются изменения
+    const model::GameSession::StateDelta* delta = nullptr;
+    // Только в режиме фиксированного шага
+    std::optional<double> interpolation_alpha;
+};
+
+std::string SerializeGameStateJson(const GameStateView& state);
+std::string SerializeGameStateMsgPack(const GameStateView& state);
+
+std::string SerializePlayersJson(std::span<const model::DogSharedPtr> dogs);
+std::string SerializePlayersMsgPack(std::span<const model::DogSharedPtr> dogs);
+
+// loot_types - описание типов лута карты из конфигурации, передаётся клиенту как есть
+std::string SerializeMapJson(const model::Map& map, const boost::json::array& loot_types);
+std::string SerializeMapMsgPack(const model::Map& map, const boost::json::array& loot_types);
+
+}  // namespace http_handler
@@ -0,0 +1,174 @@
+#include "road_network.h"
+#include "model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace model {
+
+    void RoadNetwork::Build(const std::vector<Road>& roads, double half_width) {
+        half_width_ = half_width;
+        corridors_.clear();
+        junctions_.clear();
+        road_to_corridor_.assign(roads.size(), NO_CORRIDOR);
+
+        struct Span {
+            bool horizontal;
+            double axis, begin, end;
+        };
+        std::vector<Span> spans;
+        spans.reserve(roads.size());
+        for (const auto& road : roads) {
+            const Point start = road.GetStart();
+            const Point end = road.GetEnd();
+            // Дорога нулевой длины считается горизонтальной, как и в Road::IsHorizontal
+            if (road.IsHorizontal()) {
+                spans.push_back({ true, static_cast<double>(start.y),
+                    static_cast<double>(std::min(start.x, end.x)), static_cast<double>(std::max(start.x, end.x)) });
+            }
+            else {
+                spans.push_back({ false, static_cast<double>(start.x),
+                    static_cast<double>(std::min(start.y, end.y)), static_cast<double>(std::max(start.y, end.y)) });
+            }
+        }
+
+        // Соосные дороги оказываются рядом после сортировки, и их можно слить за один проход
+        std::vector<size_t> order(spans.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&spans](size_t lhs, size_t rhs) {
+            const auto& l = spans[lhs];
+            const auto& r = spans[rhs];
+            if (l.horizontal != r.horizontal) return l.horizontal;
+            if (l.axis != r.axis) return l.axis < r.axis;
+            return l.begin < r.begin;
+            });
+
+        for (size_t road_idx : order) {
+            const auto& span = spans[road_idx];
+            if (!corridors_.empty()) {
+                auto& last = corridors_.back();
+                if (last.horizontal == span.horizontal && last.axis == span.axis && span.begin <= last.end) {
+                    last.end = std::max(last.end, span.end);
+                    road_to_corridor_[road_idx] = corridors_.size() - 1;
+                    continue;
+                }
+            }
+            corridors_.push_back({ span.horizontal, span.axis, span.begin, span.end, {} });
+            road_to_corridor_[road_idx] = corridors_.size() - 1;
+        }
+
+        // Вертикальные коридоры идут после горизонтальных и уже упорядочены по x
+        const auto first_vertical = std::find_if(corridors_.begin(), corridors_.end(),
+            [](const Corridor& c) { return !c.horizontal; });
+        const size_t vertical_offset = first_vertical - corridors_.begin();
+
+        for (size_t h = 0; h < vertical_offset; ++h) {
+            const auto from = std::lower_bound(first_vertical, corridors_.end(), corridors_[h].begin,
+                [](const Corridor& c, double x) { return c.axis < x; });
+            for (auto it = from; it != corridors_.end() && it->axis <= corridors_[h].end; ++it) {
+                const double y = corridors_[h].axis;
+                if (y < it->begin || y > it->end) {
+                    continue;
+                }
+                const size_t v = it - corridors_.begin();
+                junctions_.push_back({ it->axis, y, h, v });
+                corridors_[h].junctions.push_back(junctions_.size() - 1);
+                corridors_[v].junctions.push_back(junctions_.size() - 1);
+            }
+        }
+        for (auto& corridor : corridors_) {
+            std::sort(corridor.junctions.begin(), corridor.junctions.end(), [this, &corridor](size_t lhs, size_t rhs) {
+                return corridor.horizontal ? junctions_[lhs].x < junctions_[rhs].x : junctions_[lhs].y < junctions_[rhs].y;
+                });
+        }
+
+        std::vector<spatial::BoundingBox> boxes;
+        boxes.reserve(corridors_.size());
+        for (const auto& c : corridors_) {
+            const spatial::BoundingBox box = c.horizontal
+                ? spatial::BoundingBox{ c.begin, c.axis, c.end, c.axis }
+                : spatial::BoundingBox{ c.axis, c.begin, c.axis, c.end };
+            boxes.push_back(box.Expanded(half_width_));
+        }
+        corridor_index_.Build(boxes);
+    }
+
+    bool RoadNetwork::Contains(size_t corridor, double x, double y) const {
+        const auto& c = corridors_.at(corridor);
+        const double along = c.horizontal ? x : y;
+        const double across = c.horizontal ? y : x;
+        return std::abs(across - c.axis) <= half_width_
+            && along >= c.begin - half_width_ && along <= c.end + half_width_;
+    }
+
+    size_t RoadNetwork::Locate(double x, double y, bool prefer_horizontal) const {
+        thread_local std::vector<size_t> candidates;
+        corridor_index_.Query(spatial::BoundingBox{ x, y, x, y }, candidates);
+
+        size_t found = NO_CORRIDOR;
+        for (size_t idx : candidates) {
+            if (!Contains(idx, x, y)) {
+                continue;
+            }
+            if (corridors_[idx].horizontal == prefer_horizontal) {
+                return idx;
+            }
+            if (found == NO_CORRIDOR) {
+                found = idx;
+            }
+        }
+        return found;
+    }
+
+    size_t RoadNetwork::FindJunction(const Corridor& corridor, double along) const {
+        const auto coord = [this, &corridor](size_t j) {
+            return corridor.horizontal ? junctions_[j].x : junctions_[j].y;
+        };
+        const auto it = std::lower_bound(corridor.junctions.begin(), corridor.junctions.end(), along - half_width_,
+            [&coord](size_t j, double value) { return coord(j) < value; });
+        if (it != corridor.junctions.end() && coord(*it) <= along + half_width_) {
+            return *it;
+        }
+        return NO_JUNCTION;
+    }
+
+    bool RoadNetwork::Advance(size_t& corridor, double& x, double& y, double dx, double dy, double time) const {
+        const Corridor* current = &corridors_.at(corridor);
+        const bool moving_horizontally = dx != 0;
+
+        // Движение поперёк коридора возможно только в его ширину, если рядом нет перекрёстка
+        if (current->horizontal != moving_horizontally) {
+            const size_t junction = FindJunction(*current, current->horizontal ? x : y);
+            if (junction != NO_JUNCTION) {
+                corridor = current->horizontal ? junctions_[junction].vertical : junctions_[junction].horizontal;
+                current = &corridors_[corridor];
+            }
+        }
+
+        double& coord = moving_horizontally ? x : y;
+        const double speed = moving_horizontally ? dx : dy;
+        double low, high;
+        if (current->horizontal == moving_horizontally) {
+            low = current->begin - half_width_;
+            high = current->end + half_width_;
+        }
+        else {
+            low = current->axis - half_width_;
+            high = current->axis + half_width_;
+        }
+
+        const double next = coord + speed * time;
+        if (next >= high) {
+            coord = high;
+            return true;
+        }
+        if (next <= low) {
+            coord = low;
+            return true;
+        }
+        coord = next;
+        return false;
+    }
+
+}  // namespace model
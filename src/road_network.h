@@ -0,0 +1,75 @@
+#pragma once
+
+#include "spatial_index.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace model {
+
+class Road;
+
+/*
+ *  Скомпилированная дорожная сеть карты.
+ *  Наложенные друг на друга и стыкующиеся соосные дороги объединяются в коридоры максимальной длины,
+ *  а точки пересечения горизонтальных и вертикальных коридоров хранятся как явные узлы (перекрёстки).
+ *  Собака помнит коридор, по которому движется, и обращается к соседним коридорам только на перекрёстках.
+ */
+class RoadNetwork {
+public:
+    static constexpr size_t NO_CORRIDOR = std::numeric_limits<size_t>::max();
+    static constexpr size_t NO_JUNCTION = std::numeric_limits<size_t>::max();
+
+    struct Corridor {
+        bool horizontal;
+        // Координата оси коридора: y для горизонтального, x для вертикального
+        double axis;
+        // Границы коридора вдоль оси (begin <= end)
+        double begin, end;
+        // Перекрёстки на коридоре, упорядоченные по координате вдоль оси
+        std::vector<size_t> junctions;
+    };
+
+    struct Junction {
+        double x, y;
+        size_t horizontal;
+        size_t vertical;
+    };
+
+    // Строит сеть по дорогам карты. half_width - расстояние от оси дороги до её края
+    void Build(const std::vector<Road>& roads, double half_width);
+
+    const std::vector<Corridor>& GetCorridors() const noexcept { return corridors_; }
+
+    const std::vector<Junction>& GetJunctions() const noexcept { return junctions_; }
+
+    // Коридор, в который вошла дорога с индексом road_idx
+    size_t GetRoadCorridor(size_t road_idx) const { return road_to_corridor_.at(road_idx); }
+
+    // Находится ли точка в пределах коридора (с учётом ширины дороги)
+    bool Contains(size_t corridor, double x, double y) const;
+
+    // Ищет коридор, содержащий точку. Если их несколько (точка на перекрёстке),
+    // предпочитает коридор нужной ориентации. Возвращает NO_CORRIDOR, если точка вне дорог
+    size_t Locate(double x, double y, bool prefer_horizontal) const;
+
+    /*
+     * Перемещает точку (x, y) со скоростью (dx, dy) в течение time в пределах дорожной сети.
+     * corridor - текущий коридор, при повороте на перекрёстке он заменяется на пересекающий.
+     * Возвращает true, если движение упёрлось в край дороги.
+     */
+    bool Advance(size_t& corridor, double& x, double& y, double dx, double dy, double time) const;
+
+private:
+    // Перекрёсток на коридоре не дальше half_width_ от точки along (координата вдоль оси)
+    size_t FindJunction(const Corridor& corridor, double along) const;
+
+    std::vector<Corridor> corridors_;
+    std::vector<Junction> junctions_;
+    std::vector<size_t> road_to_corridor_;
+    spatial::BoxIndex corridor_index_;
+    double half_width_ = 0.0;
+};
+
+}  // namespace model
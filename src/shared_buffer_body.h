@@ -0,0 +1,58 @@
+#pragma once
+#include "sdk.h"
+
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/buffer.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace http_server
+{
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+
+    /*
+     *  Тело ответа, разделяемое между ответами без копирования. Ответ хранит только
+     *  указатель на неизменяемую строку и отправляет её напрямую из общего буфера.
+     *  Подходит только для ответов: чтение запроса в такое тело не поддерживается.
+     */
+    struct SharedBufferBody {
+        using value_type = std::shared_ptr<const std::string>;
+
+        static std::uint64_t size(const value_type& body) noexcept {
+            return body ? body->size() : 0;
+        }
+
+        class writer {
+        public:
+            using const_buffers_type = net::const_buffer;
+
+            template <bool isRequest, typename Fields>
+            writer(const http::header<isRequest, Fields>&, const value_type& body) : body_(body) {}
+
+            void init(beast::error_code& ec) {
+                ec = {};
+            }
+
+            boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+                ec = {};
+                if (!body_ || body_->empty()) {
+                    return boost::none;
+                }
+                return { { net::buffer(*body_), false } };
+            }
+
+        private:
+            const value_type& body_;
+        };
+    };
+
+}  // namespace http_server
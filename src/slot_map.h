@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ *  Контейнер с поколениями (slot map).
+ *  Вставка и удаление выполняются за O(1), значения лежат в плотном массиве без дыр,
+ *  а дескриптор (Handle) остаётся действительным, пока элемент не удалён.
+ *  После удаления слот получает новое поколение, поэтому старый дескриптор
+ *  не может случайно указать на элемент, вставленный в тот же слот позже.
+ *  Порядок элементов в плотном массиве не сохраняется: при удалении
+ *  на место удалённого элемента переезжает последний.
+ */
+template <typename T>
+class SlotMap {
+public:
+    struct Handle {
+        std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t generation = 0;
+
+        bool operator==(const Handle&) const = default;
+    };
+
+    Handle Insert(T value) {
+        std::uint32_t index;
+        if (free_head_ != NO_SLOT) {
+            index = free_head_;
+            free_head_ = slots_[index].dense;
+        }
+        else {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.push_back({});
+        }
+        slots_[index].dense = static_cast<std::uint32_t>(values_.size());
+        values_.push_back(std::move(value));
+        dense_to_slot_.push_back(index);
+        return { index, slots_[index].generation };
+    }
+
+    // Удаляет элемент. Возвращает false, если дескриптор уже недействителен
+    bool Erase(Handle handle) {
+        if (!Contains(handle)) {
+            return false;
+        }
+        Slot& slot = slots_[handle.index];
+        const std::uint32_t dense = slot.dense;
+        const std::uint32_t last = static_cast<std::uint32_t>(values_.size() - 1);
+        if (dense != last) {
+            values_[dense] = std::move(values_[last]);
+            dense_to_slot_[dense] = dense_to_slot_[last];
+            slots_[dense_to_slot_[dense]].dense = dense;
+        }
+        values_.pop_back();
+        dense_to_slot_.pop_back();
+
+        ++slot.generation;
+        slot.dense = free_head_;
+        free_head_ = handle.index;
+        return true;
+    }
+
+    bool Contains(Handle handle) const noexcept {
+        // Освобождённый слот всегда получает новое поколение, поэтому сравнения поколений достаточно
+        return handle.index < slots_.size() && slots_[handle.index].generation == handle.generation;
+    }
+
+    // Указатель на элемент или nullptr, если дескриптор недействителен
+    T* Get(Handle handle) noexcept {
+        return Contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+    }
+
+    const T* Get(Handle handle) const noexcept {
+        return Contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+    }
+
+    // Дескриптор элемента, находящегося в позиции dense_idx плотного массива
+    Handle GetHandle(size_t dense_idx) const {
+        assert(dense_idx < values_.size());
+        const std::uint32_t index = dense_to_slot_[dense_idx];
+        return { index, slots_[index].generation };
+    }
+
+    std::span<const T> Values() const noexcept { return values_; }
+
+    size_t Size() const noexcept { return values_.size(); }
+
+    bool Empty() const noexcept { return values_.empty(); }
+
+    void Clear() {
+        for (std::uint32_t index : dense_to_slot_) {
+            Slot& slot = slots_[index];
+            ++slot.generation;
+            slot.dense = free_head_;
+            free_head_ = index;
+        }
+        values_.clear();
+        dense_to_slot_.clear();
+    }
+
+private:
+    static constexpr std::uint32_t NO_SLOT = std::numeric_limits<std::uint32_t>::max();
+
+    struct Slot {
+        std::uint32_t generation = 0;
+        // Позиция в плотном массиве для занятого слота или следующий свободный слот для свободного
+        std::uint32_t dense = NO_SLOT;
+    };
+
+    std::vector<T> values_;
+    std::vector<std::uint32_t> dense_to_slot_;
+    std::vector<Slot> slots_;
+    std::uint32_t free_head_ = NO_SLOT;
+};
+
+}  // namespace util
@@ -0,0 +1,29 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace spatial {
+
+    void BoxIndex::Build(const std::vector<BoundingBox>& boxes) {
+        std::vector<Value> values;
+        values.reserve(boxes.size());
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            const auto& b = boxes[i];
+            values.emplace_back(Box{ Point{ b.min_x, b.min_y }, Point{ b.max_x, b.max_y } }, i);
+        }
+        // Конструктор от диапазона использует пакетную загрузку (packing) - дерево получается сбалансированным
+        tree_ = bgi::rtree<Value, bgi::rstar<16>>(values.begin(), values.end());
+    }
+
+    void BoxIndex::Query(const BoundingBox& area, std::vector<size_t>& out) const {
+        out.clear();
+        const Box query_box{ Point{ area.min_x, area.min_y }, Point{ area.max_x, area.max_y } };
+        for (auto it = tree_.qbegin(bgi::intersects(query_box)); it != tree_.qend(); ++it) {
+            out.push_back(it->second);
+        }
+        // Порядок обхода дерева не определён, а вызывающему коду важен порядок исходного вектора
+        std::sort(out.begin(), out.end());
+    }
+
+}  // namespace spatial
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace spatial {
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+
+// Ограничивающий прямоугольник, выровненный по осям
+struct BoundingBox {
+    double min_x, min_y;
+    double max_x, max_y;
+
+    // Прямоугольник, расширенный на margin во все стороны
+    BoundingBox Expanded(double margin) const {
+        return { min_x - margin, min_y - margin, max_x + margin, max_y + margin };
+    }
+
+    bool Contains(double x, double y) const {
+        return x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+    }
+};
+
+/*
+ *  Статический индекс прямоугольников (дорог, офисов и т.п.) на основе R-дерева.
+ *  Строится один раз при загрузке карты и далее используется только для чтения,
+ *  поэтому запросы к нему можно выполнять из нескольких потоков одновременно.
+ */
+class BoxIndex {
+public:
+    BoxIndex() = default;
+
+    // Строит индекс по набору прямоугольников. Идентификатор элемента - его номер в boxes
+    void Build(const std::vector<BoundingBox>& boxes);
+
+    // Записывает в out отсортированные по возрастанию идентификаторы элементов,
+    // пересекающих прямоугольник area. Содержимое out предварительно очищается
+    void Query(const BoundingBox& area, std::vector<size_t>& out) const;
+
+    size_t Size() const noexcept { return tree_.size(); }
+
+    bool Empty() const noexcept { return tree_.empty(); }
+
+private:
+    using Point = bg::model::point<double, 2, bg::cs::cartesian>;
+    using Box = bg::model::box<Point>;
+    using Value = std::pair<Box, size_t>;
+
+    bgi::rtree<Value, bgi::rstar<16>> tree_;
+};
+
+}  // namespace spatial
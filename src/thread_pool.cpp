@@ -0,0 +1,113 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    threads = std::max(1u, threads);
+    queues_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    // Очередь 0 принадлежит потоку, вызывающему Run
+    workers_.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard lock{ mutex_ };
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    workers_.clear();
+}
+
+void WorkStealingPool::Run(const std::vector<size_t>& items, const Task& task) {
+    if (items.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock{ mutex_ };
+        task_ = &task;
+        error_ = nullptr;
+        pending_ = items.size();
+        // Раздаём задачи по кругу: у каждого потока в начале очереди оказываются самые тяжёлые
+        for (size_t i = 0; i < items.size(); ++i) {
+            auto& queue = *queues_[i % queues_.size()];
+            std::lock_guard queue_lock{ queue.mutex };
+            queue.items.push_back(items[i]);
+        }
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    Execute(0);
+
+    std::unique_lock lock{ mutex_ };
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+bool WorkStealingPool::TryPop(size_t self, size_t& item) {
+    {
+        auto& own = *queues_[self];
+        std::lock_guard lock{ own.mutex };
+        if (!own.items.empty()) {
+            item = own.items.front();
+            own.items.pop_front();
+            return true;
+        }
+    }
+    // Своя очередь пуста - забираем самую лёгкую задачу у соседей
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(self + offset) % queues_.size()];
+        std::lock_guard lock{ victim.mutex };
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::Execute(size_t self) {
+    size_t item;
+    while (TryPop(self, item)) {
+        try {
+            (*task_)(item);
+        }
+        catch (...) {
+            std::lock_guard lock{ mutex_ };
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+        if (--pending_ == 0) {
+            std::lock_guard lock{ mutex_ };
+            done_cv_.notify_all();
+        }
+    }
+}
+
+void WorkStealingPool::WorkerLoop(size_t self) {
+    std::uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock{ mutex_ };
+            start_cv_.wait(lock, [this, seen_generation] { return stop_ || generation_ != seen_generation; });
+            if (stop_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+        Execute(self);
+    }
+}
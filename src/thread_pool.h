@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ *  Пул потоков с перехватом работы (work stealing) для пакетного выполнения независимых задач.
+ *  Каждый поток берёт задачи из начала своей очереди, а опустошив её - забирает задачи
+ *  с конца чужих очередей. Вызывающий Run поток тоже участвует в работе.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void(size_t)>;
+
+    // threads - общее количество потоков, включая вызывающий Run
+    explicit WorkStealingPool(unsigned threads);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /*
+     * Выполняет task(item) для каждого item из items и дожидается завершения всех задач.
+     * Задачи раздаются по очередям в порядке items, поэтому самые тяжёлые стоит ставить первыми.
+     * Первое выброшенное задачей исключение перебрасывается после завершения остальных задач.
+     */
+    void Run(const std::vector<size_t>& items, const Task& task);
+
+    unsigned GetThreadCount() const noexcept { return static_cast<unsigned>(queues_.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+
+    bool TryPop(size_t self, size_t& item);
+    void Execute(size_t self);
+    void WorkerLoop(size_t self);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::jthread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const Task* task_ = nullptr;
+    std::uint64_t generation_ = 0;
+    bool stop_ = false;
+    std::atomic<size_t> pending_{ 0 };
+    std::exception_ptr error_;
+};
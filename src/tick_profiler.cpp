@@ -0,0 +1,117 @@
+#include "tick_profiler.h"
+
+#include <algorithm>
+
+namespace profiling {
+
+const char* GetPhaseName(TickPhase phase) noexcept {
+    switch (phase) {
+    case TickPhase::MOVEMENT:
+        return "movement";
+    case TickPhase::LOOT_GATHERING:
+        return "lootGathering";
+    case TickPhase::OFFICE_DROP_OFF:
+        return "officeDropOff";
+    case TickPhase::AFK:
+        return "afk";
+    case TickPhase::LOOT_GENERATION:
+        return "lootGeneration";
+    }
+    return "unknown";
+}
+
+void RollingWindow::Add(Duration sample) {
+    if (samples_.size() < CAPACITY) {
+        samples_.push_back(sample);
+        return;
+    }
+    samples_[next_] = sample;
+    next_ = (next_ + 1) % CAPACITY;
+}
+
+RollingWindow::Summary RollingWindow::Summarize(std::vector<Duration> samples) {
+    Summary summary;
+    summary.count = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+    const auto percentile = [&samples](size_t percent) {
+        const size_t idx = (samples.size() - 1) * percent / 100;
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return samples[idx];
+    };
+    summary.p50 = percentile(50);
+    summary.p99 = percentile(99);
+    summary.max = *std::max_element(samples.begin(), samples.end());
+    return summary;
+}
+
+void TickProfiler::SetTickBudget(std::chrono::milliseconds budget) {
+    std::lock_guard lock{ mutex_ };
+    tick_budget_ = budget;
+}
+
+void TickProfiler::RecordTick(Duration duration) {
+    std::lock_guard lock{ mutex_ };
+    ++ticks_;
+    if (tick_budget_.count() > 0 && duration > tick_budget_) {
+        ++overruns_;
+    }
+    tick_window_.Add(duration);
+}
+
+void TickProfiler::RecordSessions(std::span<const SessionSample> samples) {
+    std::lock_guard lock{ mutex_ };
+    for (const auto& sample : samples) {
+        auto& profile = sessions_[sample.session_id];
+        profile.map_id = sample.map_id;
+        for (size_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+            profile.phases[phase].Add(sample.phases[phase]);
+        }
+    }
+}
+
+TickProfiler::Report TickProfiler::GetReport() const {
+    struct SessionSnapshot {
+        std::uint64_t session_id;
+        std::string map_id;
+        std::array<std::vector<Duration>, TICK_PHASE_COUNT> phases;
+    };
+
+    Report report;
+    std::vector<Duration> tick_samples;
+    std::vector<SessionSnapshot> snapshots;
+    {
+        std::lock_guard lock{ mutex_ };
+        report.tick_budget = tick_budget_;
+        report.ticks = ticks_;
+        report.overruns = overruns_;
+        tick_samples = tick_window_.GetSamples();
+        snapshots.reserve(sessions_.size());
+        for (const auto& [session_id, profile] : sessions_) {
+            SessionSnapshot& snapshot = snapshots.emplace_back();
+            snapshot.session_id = session_id;
+            snapshot.map_id = profile.map_id;
+            for (size_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+                snapshot.phases[phase] = profile.phases[phase].GetSamples();
+            }
+        }
+    }
+
+    report.tick = RollingWindow::Summarize(std::move(tick_samples));
+    report.sessions.reserve(snapshots.size());
+    for (auto& snapshot : snapshots) {
+        SessionReport& session = report.sessions.emplace_back();
+        session.session_id = snapshot.session_id;
+        session.map_id = std::move(snapshot.map_id);
+        for (size_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+            session.phases[phase] = RollingWindow::Summarize(std::move(snapshot.phases[phase]));
+        }
+    }
+    std::sort(report.sessions.begin(), report.sessions.end(), [](const SessionReport& lhs, const SessionReport& rhs) {
+        return lhs.session_id < rhs.session_id;
+        });
+    return report;
+}
+
+}  // namespace profiling
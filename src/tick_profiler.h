@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace profiling {
+
+// Фазы обновления сессии на тике
+enum class TickPhase : size_t {
+    MOVEMENT,
+    LOOT_GATHERING,
+    OFFICE_DROP_OFF,
+    AFK,
+    LOOT_GENERATION
+};
+
+inline constexpr size_t TICK_PHASE_COUNT = 5;
+
+const char* GetPhaseName(TickPhase phase) noexcept;
+
+using Clock = std::chrono::steady_clock;
+using Duration = std::chrono::nanoseconds;
+using PhaseDurations = std::array<Duration, TICK_PHASE_COUNT>;
+
+// Прибавляет время своей жизни к длительности фазы. Стоит два вызова steady_clock::now()
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseDurations& durations, TickPhase phase) noexcept
+        : target_(durations[static_cast<size_t>(phase)])
+        , start_(Clock::now()) {
+    }
+    ~PhaseTimer() {
+        target_ += std::chrono::duration_cast<Duration>(Clock::now() - start_);
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    Duration& target_;
+    Clock::time_point start_;
+};
+
+// Скользящее окно последних CAPACITY замеров. Перцентили считаются по окну при запросе
+class RollingWindow {
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    struct Summary {
+        size_t count = 0;
+        Duration p50{ 0 };
+        Duration p99{ 0 };
+        Duration max{ 0 };
+    };
+
+    void Add(Duration sample);
+    // Перцентили по замерам, снятым с окна. Порядок замеров не важен, вектор переставляется
+    static Summary Summarize(std::vector<Duration> samples);
+
+    const std::vector<Duration>& GetSamples() const noexcept { return samples_; }
+
+private:
+    std::vector<Duration> samples_;
+    size_t next_ = 0; // позиция, которую перезапишет следующий замер после заполнения окна
+};
+
+/*
+ *  Профиль тиков игры: длительность тиков целиком, число тиков, не уложившихся в период тикера,
+ *  и длительности фаз по каждой сессии.
+ *  Запись идёт из потока тика, чтение - из обработчиков HTTP-запросов, поэтому все методы
+ *  потокобезопасны. Замеры фаз копятся без блокировок и записываются один раз за тик.
+ *  Отчёт под блокировкой только копирует окна, а перцентили считает уже без неё,
+ *  чтобы не задерживать запись тика.
+ */
+class TickProfiler {
+public:
+    struct SessionSample {
+        std::uint64_t session_id = 0;
+        std::string map_id;
+        PhaseDurations phases{};
+    };
+
+    struct SessionReport {
+        std::uint64_t session_id = 0;
+        std::string map_id;
+        std::array<RollingWindow::Summary, TICK_PHASE_COUNT> phases;
+    };
+
+    struct Report {
+        std::chrono::milliseconds tick_budget{ 0 };
+        std::uint64_t ticks = 0;
+        std::uint64_t overruns = 0;
+        RollingWindow::Summary tick;
+        std::vector<SessionReport> sessions;
+    };
+
+    // Период тикера. Тики дольше него считаются перерасходом. 0 - не считать
+    void SetTickBudget(std::chrono::milliseconds budget);
+
+    void RecordTick(Duration duration);
+    void RecordSessions(std::span<const SessionSample> samples);
+
+    Report GetReport() const;
+
+private:
+    struct SessionProfile {
+        std::string map_id;
+        std::array<RollingWindow, TICK_PHASE_COUNT> phases;
+    };
+
+    mutable std::mutex mutex_;
+    std::chrono::milliseconds tick_budget_{ 0 };
+    std::uint64_t ticks_ = 0;
+    std::uint64_t overruns_ = 0;
+    RollingWindow tick_window_;
+    std::unordered_map<std::uint64_t, SessionProfile> sessions_;
+};
+
+}  // namespace profiling
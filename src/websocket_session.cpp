@@ -0,0 +1,114 @@
+#include "websocket_session.h"
+#include "http_server.h"
+
+namespace http_server
+{
+    void WebSocketSession::Run(http::request<http::string_body>&& upgrade_request, MessageHandler on_message, CloseHandler on_close) {
+        upgrade_request_ = std::move(upgrade_request);
+        on_message_ = std::move(on_message);
+        on_close_ = std::move(on_close);
+        net::dispatch(ws_.get_executor(), [self = shared_from_this()] {
+            // Таймауты HTTP-сессии здесь не подходят: соединение живёт, пока открыта игра
+            beast::get_lowest_layer(self->ws_).expires_never();
+            self->ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+            self->ws_.async_accept(self->upgrade_request_, beast::bind_front_handler(&WebSocketSession::OnAccept, self));
+            });
+    }
+
+    void WebSocketSession::Send(Frame frame) {
+        net::post(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+            self->Enqueue(std::move(frame));
+            });
+    }
+
+    void WebSocketSession::Close(websocket::close_code code) {
+        net::post(ws_.get_executor(), [self = shared_from_this(), code] {
+            if (self->finished_ || !self->accepted_) {
+                return;
+            }
+            self->ws_.async_close(code, [self](beast::error_code) {
+                self->Finish();
+                });
+            });
+    }
+
+    void WebSocketSession::OnAccept(beast::error_code ec) {
+        using namespace std::literals;
+        if (ec) {
+            ReportError(ec, "websocket accept"sv);
+            return Finish();
+        }
+        accepted_ = true;
+        upgrade_request_ = {};
+        Read();
+        if (pending_) {
+            Write();
+        }
+    }
+
+    void WebSocketSession::Read() {
+        ws_.async_read(buffer_, beast::bind_front_handler(&WebSocketSession::OnRead, shared_from_this()));
+    }
+
+    void WebSocketSession::OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read) {
+        using namespace std::literals;
+        if (ec) {
+            if (ec != websocket::error::closed) {
+                ReportError(ec, "websocket read"sv);
+            }
+            return Finish();
+        }
+        if (on_message_) {
+            on_message_(beast::buffers_to_string(buffer_.data()));
+        }
+        buffer_.consume(buffer_.size());
+        Read();
+    }
+
+    void WebSocketSession::Enqueue(Frame frame) {
+        if (finished_) {
+            return;
+        }
+        if (pending_) {
+            ++dropped_frames_;
+        }
+        pending_ = std::move(frame);
+        if (accepted_ && !writing_) {
+            Write();
+        }
+    }
+
+    void WebSocketSession::Write() {
+        writing_ = std::move(pending_);
+        pending_.reset();
+        ws_.text(true);
+        ws_.async_write(net::buffer(*writing_), beast::bind_front_handler(&WebSocketSession::OnWrite, shared_from_this()));
+    }
+
+    void WebSocketSession::OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written) {
+        using namespace std::literals;
+        writing_.reset();
+        if (ec) {
+            ReportError(ec, "websocket write"sv);
+            return Finish();
+        }
+        if (pending_ && !finished_) {
+            Write();
+        }
+    }
+
+    void WebSocketSession::Finish() {
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        pending_.reset();
+        if (on_close_) {
+            // Обработчики могут держать указатель на сессию, поэтому освобождаем их здесь
+            auto on_close = std::move(on_close_);
+            on_message_ = nullptr;
+            on_close();
+        }
+    }
+
+}  // namespace http_server
@@ -0,0 +1,73 @@
+#pragma once
+#include "sdk.h"
+
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace http_server
+{
+    namespace net = boost::asio;
+    using tcp = net::ip::tcp;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace websocket = beast::websocket;
+
+    /*
+     *  Соединение WebSocket, полученное переходом из HTTP-сессии.
+     *  Все операции выполняются в strand соединения, Send можно вызывать из любого потока.
+     *  Исходящие кадры не копятся: пока пишется один кадр, хранится только самый свежий
+     *  из ожидающих, а более старые отбрасываются. Медленный клиент получает меньше кадров,
+     *  но память сервера на него не растёт.
+     */
+    class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
+    public:
+        using Frame = std::shared_ptr<const std::string>;
+        using MessageHandler = std::function<void(std::string message)>;
+        using CloseHandler = std::function<void()>;
+
+        explicit WebSocketSession(beast::tcp_stream&& stream) : ws_(std::move(stream)) {}
+
+        WebSocketSession(const WebSocketSession&) = delete;
+        WebSocketSession& operator=(const WebSocketSession&) = delete;
+
+        // Отвечает на запрос перехода и начинает читать сообщения клиента
+        void Run(http::request<http::string_body>&& upgrade_request, MessageHandler on_message, CloseHandler on_close);
+
+        void Send(Frame frame);
+
+        void Close(websocket::close_code code);
+
+        std::uint64_t GetDroppedFrames() const noexcept { return dropped_frames_; }
+
+    private:
+        void OnAccept(beast::error_code ec);
+        void Read();
+        void OnRead(beast::error_code ec, std::size_t bytes_read);
+        void Enqueue(Frame frame);
+        void Write();
+        void OnWrite(beast::error_code ec, std::size_t bytes_written);
+        void Finish();
+
+        websocket::stream<beast::tcp_stream> ws_;
+        http::request<http::string_body> upgrade_request_;
+        beast::flat_buffer buffer_;
+        MessageHandler on_message_;
+        CloseHandler on_close_;
+        Frame writing_;
+        Frame pending_;
+        bool accepted_ = false;
+        bool finished_ = false;
+        std::atomic<std::uint64_t> dropped_frames_{ 0 };
+    };
+
+}  // namespace http_server
@@ -164,7 +164,9 @@ class GameState {
     this.lostObjects = {};
     this.disappearingLoot = {};
     this.player_elems = {};
+    this.socket = undefined;
 
+    this._openStateSocket();
     this._updateState(function() {
       self.stateLoaded = true;
       self._startGame();
@@ -183,7 +185,8 @@ class GameState {
     if (!this.started)
       return false;
 
-    if ((this.ticks % this.posUpdateInterval == 0 || this.requestInstantUpdate) && !this.updateInProgress) {
+    // While the WebSocket is open the server pushes the state itself
+    if (!this._socketOpen() && (this.ticks % this.posUpdateInterval == 0 || this.requestInstantUpdate) && !this.updateInProgress) {
       this.requestInstantUpdate = false;
       this._updateState(function() {
         self._applyDesiredState();
@@ -212,6 +215,13 @@ class GameState {
 
   _pressKey(keys, then) {
     const self = this;
+    if (this._socketOpen()) {
+      this.socket.send(JSON.stringify({
+        move: keys
+      }));
+      then();
+      return;
+    }
     $.post({
       url: '/api/v1/game/player/action',
       dataType: 'json',
@@ -409,6 +419,30 @@ class GameState {
     return abandonedLoot;
   }
 
+  _socketOpen() {
+    return this.socket !== undefined && this.socket.readyState === WebSocket.OPEN;
+  }
+
+  _openStateSocket() {
+    if (typeof WebSocket === 'undefined')
+      return;
+    const self = this;
+    const scheme = window.location.protocol === 'https:' ? 'wss://' : 'ws://';
+    const socket = new WebSocket(scheme + window.location.host + '/api/v1/game/ws?token=' + encodeURIComponent(Cookies.get('authToken')));
+    socket.onmessage = function(event) {
+      self.desiredState = JSON.parse(event.data);
+      self.stateTime = performance.now();
+      if (self.started)
+        self._applyDesiredState();
+    };
+    // On error or close, fall back to polling /api/v1/game/state
+    socket.onclose = function() {
+      if (self.socket === socket)
+        self.socket = undefined;
+    };
+    this.socket = socket;
+  }
+
   _updateState(then) {
     let self = this;
     $.get({
@@ -0,0 +1,296 @@
+#include <catch2/catch.hpp>
+
+#include "../src/collision_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace collision_detector;
+
+constexpr CollectKernel KERNELS[] = { CollectKernel::SCALAR, CollectKernel::SSE2, CollectKernel::AVX2 };
+
+std::string KernelName(CollectKernel kernel) {
+    switch (kernel) {
+    case CollectKernel::SCALAR:
+        return "scalar";
+    case CollectKernel::SSE2:
+        return "sse2";
+    case CollectKernel::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+// Побитовое сравнение: совпадать должны и NaN, и знак нуля
+bool SameBits(const CollectionResult& lhs, const CollectionResult& rhs) {
+    return std::memcmp(&lhs, &rhs, sizeof(CollectionResult)) == 0;
+}
+
+/*
+ * Сравнивает каждую поддерживаемую реализацию TryCollectPoints с TryCollectPoint.
+ * Выходной массив длиннее count: запись за его пределы тоже считается ошибкой
+ */
+void CheckKernelsMatchScalar(geom::Point2D a, geom::Point2D b, const double* xs, const double* ys, size_t count) {
+    std::vector<CollectionResult> expected;
+    expected.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        expected.push_back(TryCollectPoint(a, b, { xs[i], ys[i] }));
+    }
+
+    constexpr size_t GUARD = 4;
+    const CollectionResult sentinel{ -12345.0, 67890.0 };
+    for (const CollectKernel kernel : KERNELS) {
+        if (!IsCollectKernelSupported(kernel)) {
+            WARN("kernel " << KernelName(kernel) << " is not supported here, skipped");
+            continue;
+        }
+        std::vector<CollectionResult> out(count + GUARD, sentinel);
+        TryCollectPoints(kernel, a, b, xs, ys, count, out.data());
+        for (size_t i = 0; i < count; ++i) {
+            INFO("kernel " << KernelName(kernel) << ", count " << count << ", point " << i
+                 << " (" << xs[i] << ", " << ys[i] << "), a (" << a.x << ", " << a.y << "), b (" << b.x << ", " << b.y << ")");
+            CHECK(SameBits(out[i], expected[i]));
+        }
+        for (size_t i = count; i < count + GUARD; ++i) {
+            INFO("kernel " << KernelName(kernel) << " wrote past the end, count " << count);
+            CHECK(SameBits(out[i], sentinel));
+        }
+    }
+}
+
+void CheckKernelsMatchScalar(geom::Point2D a, geom::Point2D b, const std::vector<double>& xs, const std::vector<double>& ys) {
+    CheckKernelsMatchScalar(a, b, xs.data(), ys.data(), xs.size());
+}
+
+void CheckSameEvents(const std::vector<GatheringEvent>& actual, const std::vector<GatheringEvent>& expected) {
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        INFO("event " << i << ": gatherer " << expected[i].gatherer_id << ", item " << expected[i].item_id);
+        CHECK(actual[i].gatherer_id == expected[i].gatherer_id);
+        CHECK(actual[i].item_id == expected[i].item_id);
+        CHECK(std::memcmp(&actual[i].sq_distance, &expected[i].sq_distance, sizeof(double)) == 0);
+        CHECK(std::memcmp(&actual[i].time, &expected[i].time, sizeof(double)) == 0);
+    }
+}
+
+class VectorProvider : public ItemGathererProvider {
+public:
+    VectorProvider(std::vector<Gatherer> gatherers, std::vector<Item> items)
+        : gatherers_(std::move(gatherers))
+        , items_(std::move(items)) {
+    }
+
+    size_t ItemsCount() const override { return items_.size(); }
+    Item GetItem(size_t idx) const override { return items_.at(idx); }
+    size_t GatherersCount() const override { return gatherers_.size(); }
+    Gatherer GetGatherer(size_t idx) const override { return gatherers_.at(idx); }
+
+private:
+    std::vector<Gatherer> gatherers_;
+    std::vector<Item> items_;
+};
+
+/*
+ * Сравнивает все варианты FindGatherEvents с полным перебором. Индекс строится
+ * с разными размерами ячейки: и мельче пути собирателя, и крупнее всей карты
+ */
+void CheckGridMatchesBruteForce(const std::vector<Gatherer>& gatherers, const std::vector<Item>& items) {
+    const auto expected = FindGatherEventsBruteForce(gatherers, items);
+    {
+        INFO("span overload");
+        CheckSameEvents(FindGatherEvents(gatherers, items), expected);
+    }
+    for (const double cell_size : { 0.1, 1.0, 7.5, 1000.0 }) {
+        INFO("ItemIndex overload, cell size " << cell_size);
+        CheckSameEvents(FindGatherEvents(gatherers, ItemIndex(items, cell_size)), expected);
+    }
+    const VectorProvider provider{ gatherers, items };
+    {
+        INFO("provider overload");
+        CheckSameEvents(FindGatherEvents(provider), expected);
+    }
+    {
+        INFO("brute force provider overload");
+        CheckSameEvents(FindGatherEventsBruteForce(provider), expected);
+    }
+}
+
+}  // namespace
+
+TEST_CASE("Scalar kernel is always supported", "[TryCollectPoints]") {
+    CHECK(IsCollectKernelSupported(CollectKernel::SCALAR));
+}
+
+TEST_CASE("TryCollectPoints kernels match TryCollectPoint on random input", "[TryCollectPoints]") {
+    std::mt19937_64 rng{ 20240611 };
+    std::uniform_real_distribution<double> coord(-100.0, 100.0);
+    std::uniform_real_distribution<double> scale_exp(-6.0, 6.0);
+
+    // Длины от 0 до 37 покрывают все остатки от деления на ширину SSE2 (2) и AVX2 (4)
+    for (size_t count = 0; count <= 37; ++count) {
+        for (int iteration = 0; iteration < 50; ++iteration) {
+            const double scale = std::pow(10.0, scale_exp(rng));
+            const geom::Point2D a{ coord(rng) * scale, coord(rng) * scale };
+            const geom::Point2D b{ coord(rng) * scale, coord(rng) * scale };
+            std::vector<double> xs(count), ys(count);
+            for (size_t i = 0; i < count; ++i) {
+                xs[i] = coord(rng) * scale;
+                ys[i] = coord(rng) * scale;
+            }
+            CheckKernelsMatchScalar(a, b, xs, ys);
+        }
+    }
+}
+
+TEST_CASE("TryCollectPoints kernels match TryCollectPoint on degenerate input", "[TryCollectPoints]") {
+    const geom::Point2D a{ 1.5, -2.0 };
+    const geom::Point2D b{ 7.25, 3.0 };
+
+    SECTION("zero-length move") {
+        // Деление на нулевую длину даёт бесконечности и NaN, они тоже должны совпасть
+        for (size_t count = 0; count <= 9; ++count) {
+            std::vector<double> xs, ys;
+            for (size_t i = 0; i < count; ++i) {
+                xs.push_back(i % 3 == 0 ? a.x : a.x + static_cast<double>(i));
+                ys.push_back(i % 3 == 0 ? a.y : a.y - static_cast<double>(i) / 4.0);
+            }
+            CheckKernelsMatchScalar(a, a, xs, ys);
+        }
+    }
+
+    SECTION("points on the endpoints and on the segment") {
+        for (size_t count = 0; count <= 11; ++count) {
+            std::vector<double> xs, ys;
+            for (size_t i = 0; i < count; ++i) {
+                switch (i % 4) {
+                case 0: // начало отрезка
+                    xs.push_back(a.x);
+                    ys.push_back(a.y);
+                    break;
+                case 1: // конец отрезка
+                    xs.push_back(b.x);
+                    ys.push_back(b.y);
+                    break;
+                case 2: // середина отрезка
+                    xs.push_back((a.x + b.x) / 2.0);
+                    ys.push_back((a.y + b.y) / 2.0);
+                    break;
+                default: // на продолжении отрезка за концом
+                    xs.push_back(b.x + (b.x - a.x));
+                    ys.push_back(b.y + (b.y - a.y));
+                    break;
+                }
+            }
+            CheckKernelsMatchScalar(a, b, xs, ys);
+        }
+    }
+
+    SECTION("axis-aligned moves and signed zeros") {
+        const std::vector<double> xs{ 0.0, -0.0, 0.0, 5.0, -0.0, 3.0, 0.0 };
+        const std::vector<double> ys{ 0.0, 0.0, -0.0, 0.0, -0.0, -0.0, 2.0 };
+        CheckKernelsMatchScalar({ 0.0, 0.0 }, { 10.0, 0.0 }, xs, ys);
+        CheckKernelsMatchScalar({ -0.0, 0.0 }, { -0.0, -10.0 }, xs, ys);
+    }
+}
+
+TEST_CASE("TryCollectPoints handles unaligned input arrays", "[TryCollectPoints]") {
+    std::mt19937_64 rng{ 7 };
+    std::uniform_real_distribution<double> coord(-50.0, 50.0);
+    std::vector<double> xs_storage(40), ys_storage(40);
+    for (size_t i = 0; i < xs_storage.size(); ++i) {
+        xs_storage[i] = coord(rng);
+        ys_storage[i] = coord(rng);
+    }
+    // Смещение на один элемент сдвигает начало массивов с границы 16 и 32 байт
+    for (size_t offset = 1; offset <= 3; ++offset) {
+        CheckKernelsMatchScalar({ coord(rng), coord(rng) }, { coord(rng), coord(rng) },
+                                xs_storage.data() + offset, ys_storage.data() + offset, xs_storage.size() - offset);
+    }
+}
+
+TEST_CASE("FindGatherEvents matches brute force on random input", "[FindGatherEvents]") {
+    std::mt19937_64 rng{ 20240612 };
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    for (int iteration = 0; iteration < 300; ++iteration) {
+        // Размер карты и длина пути меняются на порядки, чтобы пройти и по сетке, и по откату на перебор
+        const double map_size = std::pow(10.0, 1.0 + 2.0 * unit(rng));
+        const double max_step = map_size * std::pow(10.0, -3.0 + 3.0 * unit(rng));
+        const size_t gatherer_count = rng() % 20;
+        const size_t item_count = rng() % 200;
+
+        std::vector<Gatherer> gatherers;
+        for (size_t i = 0; i < gatherer_count; ++i) {
+            const geom::Point2D start{ unit(rng) * map_size, unit(rng) * map_size };
+            geom::Point2D end = start;
+            switch (rng() % 4) {
+            case 0: // стоит на месте
+                break;
+            case 1: // вдоль оси x, как собака на дороге
+                end.x += (unit(rng) * 2.0 - 1.0) * max_step;
+                break;
+            case 2: // вдоль оси y
+                end.y += (unit(rng) * 2.0 - 1.0) * max_step;
+                break;
+            default:
+                end.x += (unit(rng) * 2.0 - 1.0) * max_step;
+                end.y += (unit(rng) * 2.0 - 1.0) * max_step;
+                break;
+            }
+            gatherers.push_back({ start, end, unit(rng) });
+        }
+
+        std::vector<Item> items;
+        for (size_t i = 0; i < item_count; ++i) {
+            // Часть предметов совпадает по положению с уже добавленными
+            const geom::Point2D pos = !items.empty() && rng() % 8 == 0
+                ? items[rng() % items.size()].position
+                : geom::Point2D{ unit(rng) * map_size, unit(rng) * map_size };
+            items.push_back({ pos, rng() % 4 == 0 ? 0.0 : unit(rng) });
+        }
+
+        INFO("iteration " << iteration << ", gatherers " << gatherer_count << ", items " << item_count);
+        CheckGridMatchesBruteForce(gatherers, items);
+    }
+}
+
+TEST_CASE("FindGatherEvents matches brute force on degenerate input", "[FindGatherEvents]") {
+    SECTION("no gatherers or no items") {
+        CheckGridMatchesBruteForce({}, {});
+        CheckGridMatchesBruteForce({ { { 0.0, 0.0 }, { 5.0, 0.0 }, 0.6 } }, {});
+        CheckGridMatchesBruteForce({}, { { { 1.0, 0.0 }, 0.0 } });
+    }
+
+    SECTION("all items in one point") {
+        std::vector<Item> items(50, Item{ { 3.0, 3.0 }, 0.0 });
+        CheckGridMatchesBruteForce({ { { 0.0, 3.0 }, { 10.0, 3.0 }, 0.6 }, { { 3.0, 3.0 }, { 3.0, 3.0 }, 0.6 } }, items);
+    }
+
+    SECTION("items on the ends of the path and on the width boundary") {
+        const std::vector<Item> items{
+            { { 0.0, 0.0 }, 0.0 },
+            { { 10.0, 0.0 }, 0.0 },
+            { { 5.0, 0.6 }, 0.0 },
+            { { 5.0, -0.6 }, 0.0 },
+            { { 5.0, 0.3 }, 0.3 },
+            { { -0.5, 0.0 }, 0.0 },
+            { { 10.5, 0.0 }, 0.0 },
+        };
+        CheckGridMatchesBruteForce({ { { 0.0, 0.0 }, { 10.0, 0.0 }, 0.6 } }, items);
+        CheckGridMatchesBruteForce({ { { 10.0, 0.0 }, { 0.0, 0.0 }, 0.6 } }, items);
+    }
+
+    SECTION("path much longer than the map of items") {
+        std::vector<Item> items;
+        for (int i = 0; i < 100; ++i) {
+            items.push_back({ { static_cast<double>(i % 10), static_cast<double>(i / 10) }, 0.1 });
+        }
+        CheckGridMatchesBruteForce({ { { -1000.0, 4.5 }, { 1000.0, 4.5 }, 0.6 }, { { 4.5, 1000.0 }, { 4.5, -1000.0 }, 0.6 } }, items);
+    }
+}
@@ -0,0 +1,55 @@
+#include <catch2/catch.hpp>
+
+#include "../src/json_loader.h"
+
+#include <boost/json.hpp>
+
+namespace {
+
+model::Map MakeMap() {
+    return model::Map{ model::Map::Id{ "map1" }, "Map 1" };
+}
+
+}  // namespace
+
+TEST_CASE("Session capacity is read from ordinary integer config", "[json_loader]") {
+    // Boost.JSON хранит неотрицательные числа, помещающиеся в int64, как kind::int64
+    const auto config = boost::json::parse(R"({"defaultSessionCapacity": 50})");
+    REQUIRE(config.at("defaultSessionCapacity").is_int64());
+
+    model::Game game;
+    json_loader::ConfigureGameDefaults(game, config);
+    CHECK(game.GetDefaultSessionCapacity() == 50);
+
+    SECTION("map without sessionCapacity takes the default") {
+        auto map = MakeMap();
+        json_loader::ConfigureMapDefaults(map, boost::json::object{}, game);
+        CHECK(map.GetSessionCapacity() == 50);
+    }
+
+    SECTION("map sessionCapacity overrides the default") {
+        auto map = MakeMap();
+        const auto map_obj = boost::json::parse(R"({"sessionCapacity": 7})").as_object();
+        json_loader::ConfigureMapDefaults(map, map_obj, game);
+        CHECK(map.GetSessionCapacity() == 7);
+    }
+}
+
+TEST_CASE("Session capacity defaults to unlimited", "[json_loader]") {
+    model::Game game;
+    json_loader::ConfigureGameDefaults(game, boost::json::object{});
+    CHECK(game.GetDefaultSessionCapacity() == 0);
+
+    auto map = MakeMap();
+    json_loader::ConfigureMapDefaults(map, boost::json::object{}, game);
+    CHECK(map.GetSessionCapacity() == 0);
+}
+
+TEST_CASE("Negative session capacity is rejected", "[json_loader]") {
+    model::Game game;
+    CHECK_THROWS(json_loader::ConfigureGameDefaults(game, boost::json::parse(R"({"defaultSessionCapacity": -1})")));
+
+    auto map = MakeMap();
+    const auto map_obj = boost::json::parse(R"({"sessionCapacity": -3})").as_object();
+    CHECK_THROWS(json_loader::ConfigureMapDefaults(map, map_obj, game));
+}
@@ -0,0 +1,365 @@
+#include <catch2/catch.hpp>
+
+#include "../src/response_serialization.h"
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using namespace http_handler;
+namespace json = boost::json;
+
+/*
+ * Независимый от msgpack::Writer разбор MessagePack в дерево JSON.
+ * Числовые ключи словарей превращаются в строки, как в JSON-ответе,
+ * а места, где встретились числовые ключи и float32, запоминаются
+ * в виде путей, чтобы тест мог проверить, что они стоят там, где ожидается
+ */
+class MsgPackDecoder {
+public:
+    explicit MsgPackDecoder(std::string_view data) : data_(data) {}
+
+    json::value Decode() {
+        json::value value = ReadValue("");
+        if (pos_ != data_.size()) {
+            throw std::runtime_error("trailing bytes after msgpack value");
+        }
+        return value;
+    }
+
+    const std::set<std::string>& IntKeyPaths() const { return int_key_paths_; }
+    const std::set<std::string>& Float32Paths() const { return float32_paths_; }
+
+private:
+    std::uint8_t Byte() {
+        if (pos_ >= data_.size()) {
+            throw std::runtime_error("unexpected end of msgpack data");
+        }
+        return static_cast<std::uint8_t>(data_[pos_++]);
+    }
+
+    std::uint64_t BigEndian(size_t bytes) {
+        std::uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value = (value << 8) | Byte();
+        }
+        return value;
+    }
+
+    std::string ReadString(size_t size) {
+        if (pos_ + size > data_.size()) {
+            throw std::runtime_error("string runs past the end of msgpack data");
+        }
+        std::string result(data_.substr(pos_, size));
+        pos_ += size;
+        return result;
+    }
+
+    json::value ReadArray(size_t size, const std::string& path) {
+        json::array array;
+        for (size_t i = 0; i < size; ++i) {
+            array.push_back(ReadValue(path + "/" + std::to_string(i)));
+        }
+        return array;
+    }
+
+    json::value ReadMap(size_t size, const std::string& path) {
+        json::object object;
+        for (size_t i = 0; i < size; ++i) {
+            const json::value key = ReadValue(path + "/<key>");
+            std::string key_str;
+            if (key.is_string()) {
+                key_str = std::string(key.get_string());
+            }
+            else if (key.is_uint64() || key.is_int64()) {
+                key_str = key.is_uint64() ? std::to_string(key.get_uint64()) : std::to_string(key.get_int64());
+                int_key_paths_.insert(path);
+            }
+            else {
+                throw std::runtime_error("unsupported msgpack map key at " + path);
+            }
+            object[key_str] = ReadValue(path + "/" + key_str);
+        }
+        return object;
+    }
+
+    json::value ReadValue(const std::string& path) {
+        const std::uint8_t tag = Byte();
+        if (tag <= 0x7f) {
+            return json::value(static_cast<std::uint64_t>(tag));
+        }
+        if (tag >= 0xe0) {
+            return json::value(static_cast<std::int64_t>(static_cast<std::int8_t>(tag)));
+        }
+        if ((tag & 0xf0) == 0x80) {
+            return ReadMap(tag & 0x0f, path);
+        }
+        if ((tag & 0xf0) == 0x90) {
+            return ReadArray(tag & 0x0f, path);
+        }
+        if ((tag & 0xe0) == 0xa0) {
+            return json::value(ReadString(tag & 0x1f));
+        }
+        switch (tag) {
+        case 0xc0: return json::value(nullptr);
+        case 0xc2: return json::value(false);
+        case 0xc3: return json::value(true);
+        case 0xca:
+            float32_paths_.insert(path);
+            return json::value(static_cast<double>(std::bit_cast<float>(static_cast<std::uint32_t>(BigEndian(4)))));
+        case 0xcb: return json::value(std::bit_cast<double>(BigEndian(8)));
+        case 0xcc: return json::value(BigEndian(1));
+        case 0xcd: return json::value(BigEndian(2));
+        case 0xce: return json::value(BigEndian(4));
+        case 0xcf: return json::value(BigEndian(8));
+        case 0xd0: return json::value(static_cast<std::int64_t>(static_cast<std::int8_t>(BigEndian(1))));
+        case 0xd1: return json::value(static_cast<std::int64_t>(static_cast<std::int16_t>(BigEndian(2))));
+        case 0xd2: return json::value(static_cast<std::int64_t>(static_cast<std::int32_t>(BigEndian(4))));
+        case 0xd3: return json::value(static_cast<std::int64_t>(BigEndian(8)));
+        case 0xd9: return json::value(ReadString(BigEndian(1)));
+        case 0xda: return json::value(ReadString(BigEndian(2)));
+        case 0xdb: return json::value(ReadString(BigEndian(4)));
+        case 0xdc: return ReadArray(BigEndian(2), path);
+        case 0xdd: return ReadArray(BigEndian(4), path);
+        case 0xde: return ReadMap(BigEndian(2), path);
+        case 0xdf: return ReadMap(BigEndian(4), path);
+        default:
+            throw std::runtime_error("unsupported msgpack tag " + std::to_string(tag) + " at " + path);
+        }
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+    std::set<std::string> int_key_paths_;
+    std::set<std::string> float32_paths_;
+};
+
+bool IsInteger(const json::value& value) {
+    return value.is_int64() || value.is_uint64();
+}
+
+bool SameInteger(const json::value& lhs, const json::value& rhs) {
+    const auto sign = [](const json::value& v) { return v.is_int64() && v.get_int64() < 0; };
+    if (sign(lhs) != sign(rhs)) {
+        return false;
+    }
+    const auto magnitude = [](const json::value& v) {
+        return v.is_uint64() ? v.get_uint64() : static_cast<std::uint64_t>(v.get_int64());
+    };
+    return magnitude(lhs) == magnitude(rhs);
+}
+
+double AsDouble(const json::value& value) {
+    if (value.is_double()) {
+        return value.get_double();
+    }
+    return value.is_uint64() ? static_cast<double>(value.get_uint64()) : static_cast<double>(value.get_int64());
+}
+
+/*
+ * Проверяет, что дерево из MessagePack передаёт те же данные, что и JSON.
+ * Допустимые отличия кодировок: числа в float32 равны числу из JSON, округлённому до float,
+ * номера в списках удалённых объектов записаны числами вместо строк
+ */
+void CheckEquivalent(const json::value& from_json, const json::value& from_msgpack,
+                     const MsgPackDecoder& decoder, const std::string& path = "") {
+    INFO("path: " << (path.empty() ? "/" : path));
+    if (decoder.Float32Paths().count(path)) {
+        REQUIRE(from_json.is_number());
+        CHECK(static_cast<double>(static_cast<float>(AsDouble(from_json))) == from_msgpack.get_double());
+        return;
+    }
+    if (from_json.is_string() && IsInteger(from_msgpack)) {
+        // Номера удалённых собак и лута
+        CHECK(path.find("/removed") == 0);
+        CHECK(std::string(from_json.get_string()) == std::to_string(from_msgpack.is_uint64() ? from_msgpack.get_uint64() : from_msgpack.get_int64()));
+        return;
+    }
+    if (IsInteger(from_json)) {
+        REQUIRE(IsInteger(from_msgpack));
+        CHECK(SameInteger(from_json, from_msgpack));
+        return;
+    }
+    REQUIRE(from_json.kind() == from_msgpack.kind());
+    switch (from_json.kind()) {
+    case json::kind::object: {
+        const auto& lhs = from_json.get_object();
+        const auto& rhs = from_msgpack.get_object();
+        REQUIRE(lhs.size() == rhs.size());
+        for (const auto& [key, value] : lhs) {
+            INFO("key: " << std::string(key));
+            REQUIRE(rhs.contains(key));
+            CheckEquivalent(value, rhs.at(key), decoder, path + "/" + std::string(key));
+        }
+        break;
+    }
+    case json::kind::array: {
+        const auto& lhs = from_json.get_array();
+        const auto& rhs = from_msgpack.get_array();
+        REQUIRE(lhs.size() == rhs.size());
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            CheckEquivalent(lhs[i], rhs[i], decoder, path + "/" + std::to_string(i));
+        }
+        break;
+    }
+    case json::kind::double_:
+        CHECK(from_json.get_double() == from_msgpack.get_double());
+        break;
+    default:
+        CHECK(from_json == from_msgpack);
+        break;
+    }
+}
+
+// Путь в дереве без номеров собак и лута: /players/*/pos/0
+std::string Pattern(const std::string& path) {
+    std::string result;
+    size_t pos = 0;
+    int depth = 0;
+    while (pos < path.size()) {
+        const size_t next = path.find('/', pos + 1);
+        const std::string part = path.substr(pos, next == std::string::npos ? std::string::npos : next - pos);
+        result += (depth == 1 && (result == "/players" || result == "/lostObjects")) ? "/*" : part;
+        ++depth;
+        pos = next == std::string::npos ? path.size() : next;
+    }
+    return result;
+}
+
+model::DogSharedPtr MakeDog(std::string name, model::MapPoint pos, const std::string& dir, double speed, int score) {
+    auto dog = std::make_shared<model::Dog>(std::move(name));
+    dog->SetMovementSpeed(speed);
+    dog->SetPos(pos);
+    dog->SetDirection(dir);
+    dog->SetBagCapacity(3);
+    dog->AddScore(score);
+    return dog;
+}
+
+}  // namespace
+
+TEST_CASE("Game state in MessagePack matches JSON", "[serialization]") {
+    // Координаты, которые не представимы в float точно, и номера больше одного байта
+    auto dog_a = MakeDog("Rex", { 10.37, 0.01 }, "R", 2.7, 15);
+    auto dog_b = MakeDog("Buddy", { 1234567.89, 40.25 }, "U", 1.1, 0);
+    auto dog_c = MakeDog("Idle", { 0.0, 0.0 }, "", 3.0, -7);
+    dog_b->SetId(300);
+    dog_c->SetId(70000);
+
+    auto loot_a = std::make_shared<model::Loot>(0, 10, model::MapPoint{ 3.3, 4.4 });
+    auto loot_b = std::make_shared<model::Loot>(2, 30, model::MapPoint{ 99.125, 0.1 });
+    auto loot_c = std::make_shared<model::Loot>(1, 20, model::MapPoint{ -5.0, 1e6 + 0.3 });
+    dog_a->AddLoot(loot_c);
+
+    const model::Dogs dogs{ dog_a, dog_b, dog_c };
+    const model::Loots loots{ loot_a, loot_b };
+
+    SECTION("snapshot") {
+        GameStateView state;
+        state.version = 42;
+        state.dogs = dogs;
+        state.loots = loots;
+
+        const json::value from_json = json::parse(SerializeGameStateJson(state));
+        const std::string packed = SerializeGameStateMsgPack(state);
+        MsgPackDecoder decoder{ packed };
+        const json::value from_msgpack = decoder.Decode();
+        CheckEquivalent(from_json, from_msgpack, decoder);
+
+        // Номера собак и лута, в том числе в рюкзаке, записаны числами
+        CHECK(decoder.IntKeyPaths() == std::set<std::string>{
+            "/players",
+            "/lostObjects",
+            "/players/" + std::to_string(dog_a->GetId()) + "/bag/0",
+        });
+        // В float32 записаны только координаты и скорости
+        std::set<std::string> float_patterns;
+        for (const auto& path : decoder.Float32Paths()) {
+            float_patterns.insert(Pattern(path));
+        }
+        CHECK(float_patterns == std::set<std::string>{
+            "/players/*/pos/0", "/players/*/pos/1",
+            "/players/*/speed/0", "/players/*/speed/1",
+            "/lostObjects/*/pos/0", "/lostObjects/*/pos/1",
+        });
+        CHECK(packed.size() < json::serialize(from_json).size());
+    }
+
+    SECTION("delta with removals and interpolation alpha") {
+        model::GameSession::StateDelta delta;
+        delta.changed_dogs = { dog_b };
+        delta.removed_dogs = { 5, 300000 };
+        delta.added_loots = { loot_b };
+        delta.removed_loots = { 127, 128, 65536 };
+
+        GameStateView state;
+        state.version = 100000;
+        state.dogs = delta.changed_dogs;
+        state.loots = delta.added_loots;
+        state.full = false;
+        state.delta = &delta;
+        state.interpolation_alpha = 0.3;
+
+        const json::value from_json = json::parse(SerializeGameStateJson(state));
+        const std::string packed = SerializeGameStateMsgPack(state);
+        MsgPackDecoder decoder{ packed };
+        CheckEquivalent(from_json, decoder.Decode(), decoder);
+        CHECK(from_json.as_object().contains("interpolationAlpha"));
+        CHECK(from_json.as_object().at("removedLostObjects").as_array().size() == 3);
+    }
+
+    SECTION("empty state") {
+        GameStateView state;
+        state.full = true;
+
+        const json::value from_json = json::parse(SerializeGameStateJson(state));
+        const std::string packed = SerializeGameStateMsgPack(state);
+        MsgPackDecoder decoder{ packed };
+        CheckEquivalent(from_json, decoder.Decode(), decoder);
+        CHECK(decoder.Float32Paths().empty());
+    }
+}
+
+TEST_CASE("Players list in MessagePack matches JSON", "[serialization]") {
+    const model::Dogs dogs{
+        MakeDog("Rex", { 0.0, 0.0 }, "", 1.0, 0),
+        // Имя длиннее 31 байта записывается в форме str8
+        MakeDog("A dog with a rather long name that needs str8", { 0.0, 0.0 }, "", 1.0, 0),
+    };
+    for (const auto& players : { std::span<const model::DogSharedPtr>{}, std::span<const model::DogSharedPtr>{ dogs } }) {
+        const json::value from_json = json::parse(SerializePlayersJson(players));
+        const std::string packed = SerializePlayersMsgPack(players);
+        MsgPackDecoder decoder{ packed };
+        CheckEquivalent(from_json, decoder.Decode(), decoder);
+        CHECK(decoder.IntKeyPaths().empty());
+        CHECK(decoder.Float32Paths().empty());
+    }
+}
+
+TEST_CASE("Map in MessagePack matches JSON", "[serialization]") {
+    model::Map map{ model::Map::Id{ "map1" }, "Map 1" };
+    map.AddRoad({ model::Road::HORIZONTAL, { 0, 0 }, 40 });
+    map.AddRoad({ model::Road::VERTICAL, { 40, 0 }, 30000 });
+    map.AddRoad({ model::Road::HORIZONTAL, { -200, 30000 }, 40 });
+    map.AddBuilding(model::Building{ { { 5, 5 }, { 30, 20 } } });
+    map.AddOffice(model::Office{ model::Office::Id{ "o0" }, { 40, 30 }, { 5, -5 } });
+
+    const json::array loot_types = json::parse(R"([
+        {"name": "key", "file": "assets/key.obj", "type": "obj", "rotation": 90, "color": "#338844", "scale": 0.03, "value": 10},
+        {"name": "wallet", "file": "assets/wallet.obj", "type": "obj", "rotation": 0, "color": "#883344", "scale": 0.01, "value": 30}
+    ])").as_array();
+
+    const json::value from_json = json::parse(SerializeMapJson(map, loot_types));
+    const std::string packed = SerializeMapMsgPack(map, loot_types);
+    MsgPackDecoder decoder{ packed };
+    CheckEquivalent(from_json, decoder.Decode(), decoder);
+    CHECK(decoder.IntKeyPaths().empty());
+    CHECK(decoder.Float32Paths().empty());
+}